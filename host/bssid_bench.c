@@ -0,0 +1,239 @@
+// Times main/bssid_table.c against the uthash table it replaced, in ns per operation:
+//
+//   hit    lookup of a BSSID in the table (every frame from a known AP)
+//   miss   lookup of a BSSID that is not (the first frame of a new one)
+//   churn  remove one entry and insert it again (eviction followed by an add)
+//
+// The table size is fixed at compile time, host/CMakeLists.txt builds one binary per size with
+// MAX_SCAN_RESULTS and BSSID_TABLE_SLOTS overridden: bssid_bench_30 (the firmware), _256, _4096.
+// BSSIDs share a handful of vendor prefixes like a real neighbourhood does.
+//
+//   bssid_bench [rounds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bssid_table.h"
+#include "uthash.h"
+
+#define OPS_PER_ROUND 4096
+#define DEFAULT_ROUNDS 2000
+#define NUM_OUIS 4
+
+typedef struct ut_entry_t
+{
+    uint8_t bssid[6];
+    scan_result_t *entry;
+    UT_hash_handle hh;
+} ut_entry_t;
+
+static const uint8_t ouis[NUM_OUIS][3] = {{0x00, 0x11, 0x22}, {0x3c, 0x84, 0x6a}, {0xa4, 0x2b, 0xb0}, {0xf0, 0x9f, 0xc2}};
+
+static scan_result_t entries[MAX_SCAN_RESULTS];
+static ut_entry_t ut_entries[MAX_SCAN_RESULTS];
+static uint8_t absent[MAX_SCAN_RESULTS][6]; // never inserted, for misses
+static uint16_t order[OPS_PER_ROUND];       // which entry each operation uses
+
+static bssid_table_t table;
+static ut_entry_t *ut_head = NULL;
+
+static uint32_t rng_state = 0x2545F491;
+
+static uint32_t xorshift32()
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void random_bssid(uint8_t bssid[6])
+{
+    memcpy(bssid, ouis[xorshift32() % NUM_OUIS], 3);
+    uint32_t nic = xorshift32();
+    bssid[3] = (uint8_t)(nic >> 16);
+    bssid[4] = (uint8_t)(nic >> 8);
+    bssid[5] = (uint8_t)nic;
+}
+
+static bool is_used(const uint8_t bssid[6], int filled)
+{
+    for (int i = 0; i < filled; i++)
+    {
+        if (memcmp(entries[i].bssid, bssid, 6) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_tables()
+{
+    for (int i = 0; i < MAX_SCAN_RESULTS; i++)
+    {
+        do
+        {
+            random_bssid(entries[i].bssid);
+        } while (is_used(entries[i].bssid, i));
+    }
+    for (int i = 0; i < MAX_SCAN_RESULTS; i++)
+    {
+        do
+        {
+            random_bssid(absent[i]);
+        } while (is_used(absent[i], MAX_SCAN_RESULTS));
+    }
+    for (int i = 0; i < OPS_PER_ROUND; i++)
+    {
+        order[i] = (uint16_t)(xorshift32() % MAX_SCAN_RESULTS);
+    }
+
+    bssid_table_init(&table);
+    for (int i = 0; i < MAX_SCAN_RESULTS; i++)
+    {
+        if (!bssid_table_insert(&table, bssid_key(entries[i].bssid), &entries[i]))
+        {
+            fprintf(stderr, "bssid_table full at %d entries\n", i);
+            exit(1);
+        }
+        memcpy(ut_entries[i].bssid, entries[i].bssid, 6);
+        ut_entries[i].entry = &entries[i];
+        HASH_ADD(hh, ut_head, bssid, 6, &ut_entries[i]);
+    }
+}
+
+// Accumulates every lookup result so the compiler cannot drop the loops
+static uintptr_t sink;
+
+static void table_hit(unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < OPS_PER_ROUND; i++)
+        {
+            sink += (uintptr_t)bssid_table_find(&table, bssid_key(entries[order[i]].bssid));
+        }
+    }
+}
+
+static void table_miss(unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < OPS_PER_ROUND; i++)
+        {
+            sink += (uintptr_t)bssid_table_find(&table, bssid_key(absent[order[i]]));
+        }
+    }
+}
+
+static void table_churn(unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < OPS_PER_ROUND; i++)
+        {
+            uint64_t key = bssid_key(entries[order[i]].bssid);
+            scan_result_t *entry = bssid_table_remove(&table, key);
+            sink += bssid_table_insert(&table, key, entry);
+        }
+    }
+}
+
+static void ut_hit(unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < OPS_PER_ROUND; i++)
+        {
+            ut_entry_t *found;
+            HASH_FIND(hh, ut_head, entries[order[i]].bssid, 6, found);
+            sink += (uintptr_t)found;
+        }
+    }
+}
+
+static void ut_miss(unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < OPS_PER_ROUND; i++)
+        {
+            ut_entry_t *found;
+            HASH_FIND(hh, ut_head, absent[order[i]], 6, found);
+            sink += (uintptr_t)found;
+        }
+    }
+}
+
+static void ut_churn(unsigned rounds)
+{
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < OPS_PER_ROUND; i++)
+        {
+            ut_entry_t *found;
+            HASH_FIND(hh, ut_head, entries[order[i]].bssid, 6, found);
+            HASH_DEL(ut_head, found);
+            HASH_ADD(hh, ut_head, bssid, 6, found);
+            sink += (uintptr_t)found;
+        }
+    }
+}
+
+// ns per operation, the best of a few runs so a preempted run does not count
+static double ns_per_op(void (*run)(unsigned), unsigned rounds)
+{
+    double best = 0;
+    for (int attempt = 0; attempt < 3; attempt++)
+    {
+        double start = now_ns();
+        run(rounds);
+        double ns = (now_ns() - start) / ((double)rounds * OPS_PER_ROUND);
+        if (attempt == 0 || ns < best)
+        {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned rounds = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : DEFAULT_ROUNDS;
+    if (argc > 2 || rounds == 0)
+    {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return 2;
+    }
+    fill_tables();
+
+    printf("%d entries, %d slots, %u x %d ops\n", MAX_SCAN_RESULTS, BSSID_TABLE_SLOTS, rounds, OPS_PER_ROUND);
+    printf("op     bssid_table     uthash\n");
+    printf("hit    %8.2f ns %8.2f ns\n", ns_per_op(table_hit, rounds), ns_per_op(ut_hit, rounds));
+    printf("miss   %8.2f ns %8.2f ns\n", ns_per_op(table_miss, rounds), ns_per_op(ut_miss, rounds));
+    printf("churn  %8.2f ns %8.2f ns\n", ns_per_op(table_churn, rounds), ns_per_op(ut_churn, rounds));
+
+    // every entry must still be findable in both after the churn
+    for (int i = 0; i < MAX_SCAN_RESULTS; i++)
+    {
+        ut_entry_t *found;
+        HASH_FIND(hh, ut_head, entries[i].bssid, 6, found);
+        if (bssid_table_find(&table, bssid_key(entries[i].bssid)) != &entries[i] || !found || found->entry != &entries[i])
+        {
+            fprintf(stderr, "entry %d lost\n", i);
+            return 1;
+        }
+    }
+    HASH_CLEAR(hh, ut_head);
+    return sink ? 0 : 1;
+}
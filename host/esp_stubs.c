@@ -0,0 +1,806 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "host_sim.h"
+
+// Simulated ESP-IDF layer for the host build.
+// Everything runs on the replay driver's thread; time only moves in host_sim_advance_to().
+
+#define HOST_MAX_TIMERS 16
+#define HOST_MAX_HANDLERS 16
+#define HOST_NVS_KEYS 16
+#define HOST_NVS_BLOB_MAX 1024
+#define HOST_SCAN_APS 64 // APs a simulated driver scan can hold
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    bool in_use;
+    bool active;
+    int64_t expiry;
+    uint64_t period; // 0 for one-shot timers
+};
+
+typedef struct
+{
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} host_handler_t;
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+static struct esp_timer timers[HOST_MAX_TIMERS];
+static host_handler_t handlers[HOST_MAX_HANDLERS];
+static int64_t sim_now = 0;
+static int log_level = ESP_LOG_INFO;
+static void (*task_hook)(void) = NULL;
+
+static uint8_t wifi_channel = 1;
+static bool wifi_promiscuous = false;
+static wifi_promiscuous_cb_t wifi_rx_cb = NULL;
+static uint32_t wifi_tx_count = 0;
+static wifi_config_t wifi_sta_config;
+static bool wifi_connected = false; // esp_wifi_connect always succeeds at once
+static uint8_t wifi_home_channel = 0;
+static wifi_country_t wifi_country = {.cc = "01", .schan = 1, .nchan = 11};
+static const uint8_t host_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t host_ap_bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0xa9};
+
+// Simulated NVS, one namespace's worth of blobs is all the firmware uses
+typedef struct
+{
+    char key[16];
+    uint16_t len;
+    uint8_t data[HOST_NVS_BLOB_MAX];
+} host_nvs_entry_t;
+
+// Simulated driver scan: visits each channel for scan_time.active.max and keeps every AP it hears
+// in a beacon or probe response from the air while on that channel
+static esp_timer_handle_t scan_timer = NULL;
+static bool scan_active = false;
+static int64_t scan_start_us = 0;
+static int64_t scan_chan_us = 0;
+static uint8_t scan_first_chan = 1;
+static wifi_ap_record_t scan_aps[HOST_SCAN_APS];
+static uint16_t scan_num_aps = 0;
+static uint16_t scan_next_ap = 0; // next record esp_wifi_scan_get_ap_record hands out
+
+static host_nvs_entry_t nvs_entries[HOST_NVS_KEYS];
+static int nvs_num_entries = 0;
+static bool nvs_dirty = false;
+static uint32_t nvs_commits = 0;
+
+/************************************************************
+ *                      SIM CONTROL                         *
+ ************************************************************/
+
+static struct esp_timer *earliest_timer(void)
+{
+    struct esp_timer *earliest = NULL;
+    for (int i = 0; i < HOST_MAX_TIMERS; i++)
+    {
+        if (timers[i].in_use && timers[i].active && (!earliest || timers[i].expiry < earliest->expiry))
+        {
+            earliest = &timers[i];
+        }
+    }
+    return earliest;
+}
+
+void host_sim_advance_to(int64_t now_us)
+{
+    struct esp_timer *timer;
+    while ((timer = earliest_timer()) != NULL && timer->expiry <= now_us)
+    {
+        if (timer->expiry > sim_now)
+        {
+            sim_now = timer->expiry;
+        }
+        if (timer->period)
+        {
+            timer->expiry += timer->period;
+        }
+        else
+        {
+            timer->active = false;
+        }
+        timer->callback(timer->arg);
+        if (task_hook)
+        {
+            task_hook();
+        }
+    }
+    if (now_us > sim_now)
+    {
+        sim_now = now_us;
+    }
+}
+
+void host_sim_set_task_hook(void (*hook)(void))
+{
+    task_hook = hook;
+}
+
+bool host_sim_next_timer(int64_t *expiry_us)
+{
+    struct esp_timer *timer = earliest_timer();
+    if (!timer)
+    {
+        return false;
+    }
+    *expiry_us = timer->expiry;
+    return true;
+}
+
+uint8_t host_sim_channel(void)
+{
+    return wifi_channel;
+}
+
+wifi_promiscuous_cb_t host_sim_rx_cb(void)
+{
+    return wifi_promiscuous ? wifi_rx_cb : NULL;
+}
+
+uint32_t host_sim_tx_count(void)
+{
+    return wifi_tx_count;
+}
+
+void host_sim_post_event(esp_event_base_t base, int32_t id, void *data)
+{
+    for (int i = 0; i < HOST_MAX_HANDLERS; i++)
+    {
+        host_handler_t *h = &handlers[i];
+        if (h->handler && h->base == base && (h->id == ESP_EVENT_ANY_ID || h->id == id))
+        {
+            h->handler(h->arg, base, id, data);
+        }
+    }
+}
+
+void host_sim_air_frame(const uint8_t *frame, size_t len, uint8_t channel, int8_t rssi)
+{
+    if (!scan_active || len < 36)
+    {
+        return;
+    }
+    uint8_t subtype = frame[0] & 0xFC;
+    if (subtype != 0x80 && subtype != 0x50) // beacon, probe response
+    {
+        return;
+    }
+
+    wifi_ap_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.bssid, frame + 16, 6);
+    rec.rssi = rssi;
+    rec.phy_11b = 1;
+    rec.primary = channel;
+    for (size_t pos = 36; pos + 2 <= len && pos + 2 + frame[pos + 1] <= len; pos += 2 + frame[pos + 1])
+    {
+        const uint8_t *ie = frame + pos;
+        if (ie[0] == 0 && ie[1] <= 32)
+        {
+            memcpy(rec.ssid, ie + 2, ie[1]);
+        }
+        else if (ie[0] == 3 && ie[1] == 1)
+        {
+            rec.primary = ie[2];
+        }
+        else if (ie[0] == 45)
+        {
+            rec.phy_11n = 1;
+        }
+        else if (ie[0] == 48)
+        {
+            rec.authmode = WIFI_AUTH_WPA2_PSK;
+        }
+    }
+
+    // only what is on the air on the channel the scan is visiting right now
+    uint8_t scan_chan = scan_first_chan + (uint8_t)((sim_now - scan_start_us) / scan_chan_us);
+    if ((channel ? channel : rec.primary) != scan_chan)
+    {
+        return;
+    }
+
+    for (uint16_t i = 0; i < scan_num_aps; i++)
+    {
+        if (memcmp(scan_aps[i].bssid, rec.bssid, 6) == 0)
+        {
+            scan_aps[i] = rec;
+            return;
+        }
+    }
+    if (scan_num_aps < HOST_SCAN_APS)
+    {
+        scan_aps[scan_num_aps++] = rec;
+    }
+}
+
+void host_sim_set_log_level(int level)
+{
+    log_level = level;
+}
+
+/************************************************************
+ *                  ESP-IDF / FREERTOS                      *
+ ************************************************************/
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_WIFI_STATE:
+        return "ESP_ERR_WIFI_STATE";
+    case ESP_ERR_WIFI_NOT_CONNECT:
+        return "ESP_ERR_WIFI_NOT_CONNECT";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    if ((int)level > log_level)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    printf("%c (%lld) %s: ", letters[level], (long long)(sim_now / 1000), tag);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+    // tasks are not run, the replay driver calls their work functions directly
+    (void)fn;
+    (void)name;
+    (void)stack_depth;
+    (void)arg;
+    (void)prio;
+    static int task_count = 0;
+    if (handle)
+    {
+        *handle = (TaskHandle_t)(intptr_t)++task_count;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stack_depth, arg, prio, handle);
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    (void)handle;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    (void)clear_on_exit;
+    (void)ticks_to_wait;
+    return 1;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    (void)handle;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_sim_advance_to(sim_now + (int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    for (int i = 0; i < HOST_MAX_TIMERS; i++)
+    {
+        if (!timers[i].in_use)
+        {
+            memset(&timers[i], 0, sizeof(timers[i]));
+            timers[i].in_use = true;
+            timers[i].callback = create_args->callback;
+            timers[i].arg = create_args->arg;
+            timers[i].name = create_args->name;
+            *out_handle = &timers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->active)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->period = 0;
+    timer->expiry = sim_now + (int64_t)timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    if (timer->active)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->period = period;
+    timer->expiry = sim_now + (int64_t)period;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->active)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer->active)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->in_use = false;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->active;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_now;
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    for (int i = 0; i < HOST_MAX_HANDLERS; i++)
+    {
+        if (!handlers[i].handler)
+        {
+            handlers[i] = (host_handler_t){event_base, event_id, event_handler, event_handler_arg};
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+                                       esp_event_handler_t event_handler)
+{
+    for (int i = 0; i < HOST_MAX_HANDLERS; i++)
+    {
+        if (handlers[i].handler == event_handler && handlers[i].base == event_base && handlers[i].id == event_id)
+        {
+            handlers[i].handler = NULL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+    return NULL;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    nvs_num_entries = 0;
+    return ESP_OK;
+}
+
+static host_nvs_entry_t *nvs_find(const char *key)
+{
+    for (int i = 0; i < nvs_num_entries; i++)
+    {
+        if (strncmp(nvs_entries[i].key, key, sizeof(nvs_entries[i].key)) == 0)
+        {
+            return &nvs_entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void)namespace_name;
+    (void)open_mode;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    (void)handle;
+    host_nvs_entry_t *entry = nvs_find(key);
+    if (!entry)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (!out_value)
+    {
+        *length = entry->len;
+        return ESP_OK;
+    }
+    if (*length < entry->len)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, entry->data, entry->len);
+    *length = entry->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    (void)handle;
+    if (strlen(key) >= sizeof(nvs_entries[0].key) || length > HOST_NVS_BLOB_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_nvs_entry_t *entry = nvs_find(key);
+    if (!entry)
+    {
+        if (nvs_num_entries == HOST_NVS_KEYS)
+        {
+            return ESP_ERR_NVS_NO_FREE_PAGES;
+        }
+        entry = &nvs_entries[nvs_num_entries++];
+        strcpy(entry->key, key);
+    }
+    memcpy(entry->data, value, length);
+    entry->len = (uint16_t)length;
+    nvs_dirty = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    if (nvs_dirty)
+    {
+        nvs_commits += 1;
+        nvs_dirty = false;
+    }
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+bool host_sim_nvs_load(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        return false;
+    }
+    int n = (int)fread(nvs_entries, sizeof(nvs_entries[0]), HOST_NVS_KEYS, fp);
+    fclose(fp);
+    nvs_num_entries = n;
+    return n > 0;
+}
+
+bool host_sim_nvs_save(const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+    {
+        return false;
+    }
+    size_t n = fwrite(nvs_entries, sizeof(nvs_entries[0]), nvs_num_entries, fp);
+    fclose(fp);
+    return n == (size_t)nvs_num_entries;
+}
+
+uint32_t host_sim_nvs_commits(void)
+{
+    return nvs_commits;
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type)
+{
+    (void)type;
+    memcpy(mac, host_mac, sizeof(host_mac));
+    return ESP_OK;
+}
+
+/************************************************************
+ *                          WI-FI                           *
+ ************************************************************/
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_country(const wifi_country_t *country)
+{
+    wifi_country = *country;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_country(wifi_country_t *country)
+{
+    *country = wifi_country;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage)
+{
+    (void)storage;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    (void)type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t *filter)
+{
+    (void)filter;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous(bool en)
+{
+    wifi_promiscuous = en;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb)
+{
+    wifi_rx_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_config_80211_tx_rate(wifi_interface_t ifx, wifi_phy_rate_t rate)
+{
+    (void)ifx;
+    (void)rate;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol_bitmap)
+{
+    (void)ifx;
+    (void)protocol_bitmap;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    wifi_connected = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_max_tx_power(int8_t power)
+{
+    (void)power;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    (void)second;
+    if (primary < 1 || primary > 14)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    wifi_channel = primary;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+    *primary = wifi_channel;
+    *second = WIFI_SECOND_CHAN_NONE;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t bw)
+{
+    (void)ifx;
+    (void)bw;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    (void)interface;
+    wifi_sta_config = *conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    wifi_connected = true;
+    wifi_home_channel = wifi_sta_config.sta.channel ? wifi_sta_config.sta.channel : wifi_channel;
+    wifi_channel = wifi_home_channel;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    wifi_connected = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    if (!wifi_connected)
+    {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    memset(ap_info, 0, sizeof(*ap_info));
+    // without a bssid hint the driver would have picked one in its own scan, stand in for it
+    memcpy(ap_info->bssid, wifi_sta_config.sta.bssid_set ? wifi_sta_config.sta.bssid : host_ap_bssid, 6);
+    memcpy(ap_info->ssid, wifi_sta_config.sta.ssid, sizeof(wifi_sta_config.sta.ssid));
+    ap_info->primary = wifi_home_channel;
+    return ESP_OK;
+}
+
+static void scan_done_cb(void *arg)
+{
+    (void)arg;
+    scan_active = false;
+    wifi_event_sta_scan_done_t done = {.status = 0, .number = (uint8_t)scan_num_aps};
+    host_sim_post_event(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &done);
+}
+
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block)
+{
+    (void)block;
+    // block is ignored, time cannot pass inside a timer callback here. SCAN_DONE is posted from a
+    // timer once every channel has been visited.
+    if (scan_active)
+    {
+        return ESP_ERR_WIFI_STATE;
+    }
+    if (!scan_timer)
+    {
+        const esp_timer_create_args_t args = {.callback = &scan_done_cb, .name = "host_scan"};
+        esp_timer_create(&args, &scan_timer);
+    }
+
+    uint8_t nchan = config->channel ? 1 : wifi_country.nchan;
+    scan_first_chan = config->channel ? config->channel : wifi_country.schan;
+    scan_chan_us = (int64_t)(config->scan_time.active.max ? config->scan_time.active.max : 120) * 1000;
+    scan_start_us = sim_now;
+    scan_num_aps = 0;
+    scan_next_ap = 0;
+    scan_active = true;
+    return esp_timer_start_once(scan_timer, (uint64_t)(nchan * scan_chan_us));
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number)
+{
+    *number = scan_num_aps - scan_next_ap;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_record(wifi_ap_record_t *ap_record)
+{
+    if (scan_next_ap >= scan_num_aps)
+    {
+        return ESP_FAIL;
+    }
+    *ap_record = scan_aps[scan_next_ap++];
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_clear_ap_list(void)
+{
+    scan_num_aps = 0;
+    scan_next_ap = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_80211_tx(wifi_interface_t ifx, const void *buffer, int len, bool en_sys_seq)
+{
+    (void)ifx;
+    (void)buffer;
+    (void)len;
+    if (wifi_connected && !en_sys_seq)
+    {
+        return ESP_ERR_INVALID_ARG; // like the real driver, which owns the sequence space once associated
+    }
+    wifi_tx_count += 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    (void)ifx;
+    memcpy(mac, host_mac, 6);
+    return ESP_OK;
+}
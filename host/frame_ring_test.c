@@ -0,0 +1,247 @@
+// Stress test for main/frame_ring.c, the SPSC ring between the promiscuous RX callback and the
+// scan RX task. A producer thread pushes numbered frames of varying length as fast as it can. Like
+// the driver it never retries a frame the ring refused, it yields and moves on to the next one.
+// The main thread consumes and checks that
+//   - frames come out in push order with their payload and metadata intact
+//   - every frame is either consumed or counted as dropped, and pushed/dropped/truncated match
+//     what the producer saw
+//   - high_water stays within the ring and reaches it once the consumer stalls
+// The consumer stalls now and then so the full-ring path is exercised too. Build with
+// -fsanitize=thread to also have the memory ordering checked.
+//
+//   frame_ring_test [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "frame_ring.h"
+
+#define DEFAULT_FRAMES 2000000
+#define MAX_FRAME_LEN 400     // longer than FRAME_SLOT_SIZE, so some frames are truncated
+#define STALL_EVERY 8192      // frames consumed between consumer stalls
+#define STALL_YIELDS 200
+
+typedef struct producer_t
+{
+    frame_ring_t *ring;
+    uint32_t frames;
+    // what the producer saw, compared with the ring's own stats at the end
+    uint32_t accepted;
+    uint32_t refused;
+    uint32_t truncated;
+    atomic_bool done;
+} producer_t;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if (!(cond))                                                                 \
+        {                                                                            \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures += 1;                                                           \
+        }                                                                            \
+    } while (0)
+
+static uint16_t frame_len_of(uint32_t seq)
+{
+    return (uint16_t)(24 + (seq * 7919u) % (MAX_FRAME_LEN - 24 + 1));
+}
+
+static uint8_t payload_byte(uint32_t seq, unsigned i)
+{
+    return (uint8_t)(seq * 31u + i);
+}
+
+// Sequence number in the first 4 bytes, a pattern derived from it after that
+static void fill_frame(uint8_t *frame, uint32_t seq, uint16_t len)
+{
+    memcpy(frame, &seq, sizeof(seq));
+    for (unsigned i = sizeof(seq); i < len; i++)
+    {
+        frame[i] = payload_byte(seq, i);
+    }
+}
+
+static void *producer_main(void *arg)
+{
+    producer_t *p = arg;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    for (uint32_t seq = 0; seq < p->frames; seq++)
+    {
+        uint16_t len = frame_len_of(seq);
+        fill_frame(frame, seq, len);
+        if (frame_ring_push(p->ring, frame, len, (int8_t)-(int)(seq % 90), (uint8_t)(1 + seq % 13), seq * 3))
+        {
+            p->accepted += 1;
+            p->truncated += len > FRAME_SLOT_SIZE;
+        }
+        else
+        {
+            // the next frame takes a while on air, give the consumer the CPU meanwhile
+            p->refused += 1;
+            sched_yield();
+        }
+    }
+    atomic_store_explicit(&p->done, true, memory_order_release);
+    return NULL;
+}
+
+// Checks one slot against the frame its sequence number says it is, returns the sequence number
+static uint32_t check_slot(const frame_slot_t *slot)
+{
+    uint32_t seq;
+    memcpy(&seq, slot->data, sizeof(seq));
+
+    uint16_t len = frame_len_of(seq);
+    uint16_t copied = len > FRAME_SLOT_SIZE ? FRAME_SLOT_SIZE : len;
+    CHECK(slot->frame_len == len);
+    CHECK(slot->len == copied);
+    CHECK(slot->rssi == (int8_t)-(int)(seq % 90));
+    CHECK(slot->channel == 1 + seq % 13);
+    CHECK(slot->rx_time == seq * 3);
+    for (unsigned i = sizeof(seq); i < copied; i++)
+    {
+        if (slot->data[i] != payload_byte(seq, i))
+        {
+            fprintf(stderr, "frame %u: payload byte %u corrupted\n", (unsigned)seq, i);
+            failures += 1;
+            break;
+        }
+    }
+    return seq;
+}
+
+// Single threaded: fill past capacity, then drain
+static void test_fill_and_drain()
+{
+    static frame_ring_t ring;
+    frame_ring_init(&ring);
+    uint8_t frame[MAX_FRAME_LEN];
+
+    CHECK(frame_ring_peek(&ring) == NULL);
+    for (uint32_t seq = 0; seq < FRAME_RING_SLOTS + 8; seq++)
+    {
+        uint16_t len = frame_len_of(seq);
+        fill_frame(frame, seq, len);
+        bool pushed = frame_ring_push(&ring, frame, len, (int8_t)-(int)(seq % 90), (uint8_t)(1 + seq % 13), seq * 3);
+        CHECK(pushed == (seq < FRAME_RING_SLOTS));
+    }
+
+    frame_ring_stats_t stats;
+    frame_ring_get_stats(&ring, &stats);
+    CHECK(stats.pushed == FRAME_RING_SLOTS);
+    CHECK(stats.dropped == 8);
+    CHECK(stats.high_water == FRAME_RING_SLOTS);
+
+    for (uint32_t seq = 0; seq < FRAME_RING_SLOTS; seq++)
+    {
+        const frame_slot_t *slot = frame_ring_peek(&ring);
+        CHECK(slot != NULL);
+        if (!slot)
+        {
+            return;
+        }
+        CHECK(check_slot(slot) == seq);
+        frame_ring_release(&ring);
+    }
+    CHECK(frame_ring_peek(&ring) == NULL);
+}
+
+static void test_concurrent(uint32_t frames)
+{
+    static frame_ring_t ring;
+    frame_ring_init(&ring);
+
+    static producer_t producer;
+    producer.ring = &ring;
+    producer.frames = frames;
+    atomic_init(&producer.done, false);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, producer_main, &producer) != 0)
+    {
+        perror("pthread_create");
+        exit(1);
+    }
+
+    uint32_t consumed = 0;
+    int64_t last_seq = -1;
+    while (true)
+    {
+        // read done before peeking, so an empty ring after done really is the end
+        bool done = atomic_load_explicit(&producer.done, memory_order_acquire);
+        const frame_slot_t *slot = frame_ring_peek(&ring);
+        if (!slot)
+        {
+            if (done)
+            {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        uint32_t seq = check_slot(slot);
+        if ((int64_t)seq <= last_seq)
+        {
+            fprintf(stderr, "frame %u after frame %lld\n", (unsigned)seq, (long long)last_seq);
+            failures += 1;
+        }
+        last_seq = seq;
+        frame_ring_release(&ring);
+
+        consumed += 1;
+        if (consumed % STALL_EVERY == 0)
+        {
+            // let the producer run into a full ring
+            for (int i = 0; i < STALL_YIELDS; i++)
+            {
+                sched_yield();
+            }
+        }
+    }
+    pthread_join(thread, NULL);
+
+    frame_ring_stats_t stats;
+    frame_ring_get_stats(&ring, &stats);
+    printf("%u frames: %u consumed, %u dropped, %u truncated, high water %u/%d\n", (unsigned)frames,
+           (unsigned)consumed, (unsigned)stats.dropped, (unsigned)stats.truncated, (unsigned)stats.high_water,
+           FRAME_RING_SLOTS);
+
+    CHECK(producer.accepted + producer.refused == frames);
+    CHECK(consumed == producer.accepted);
+    CHECK(stats.pushed == producer.accepted);
+    CHECK(stats.dropped == producer.refused);
+    CHECK(stats.truncated == producer.truncated);
+    CHECK(stats.truncated > 0);
+    CHECK(stats.high_water >= 1 && stats.high_water <= FRAME_RING_SLOTS);
+    // the stalls fill the ring whenever the producer gets to run during them
+    CHECK(stats.dropped == 0 || stats.high_water == FRAME_RING_SLOTS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_FRAMES;
+    if (argc > 2 || frames == 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 2;
+    }
+
+    test_fill_and_drain();
+    test_concurrent(frames);
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("frame_ring: all checks passed\n");
+    return 0;
+}
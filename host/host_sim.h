@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_wifi.h"
+#include "esp_event.h"
+
+// Controls for the simulated ESP-IDF layer in esp_stubs.c, used by the replay driver
+
+// Move simulated time forward to now_us, running every esp_timer callback that expires on the way
+void host_sim_advance_to(int64_t now_us);
+
+// Work function run after every esp_timer callback, standing in for the task the callback wakes.
+// Tasks never run on the host, see freertos/task.h.
+void host_sim_set_task_hook(void (*hook)(void));
+
+// Expiry of the earliest armed timer, false when no timer is armed
+bool host_sim_next_timer(int64_t *expiry_us);
+
+// Channel the radio is tuned to
+uint8_t host_sim_channel(void);
+
+// Promiscuous callback, NULL unless promiscuous mode is on and a callback is registered
+wifi_promiscuous_cb_t host_sim_rx_cb(void);
+
+// Number of frames handed to esp_wifi_80211_tx
+uint32_t host_sim_tx_count(void);
+
+// Every frame on the air, whatever the radio is tuned to. A driver scan in progress keeps the APs
+// it hears in beacons and probe responses on the channel it is visiting. channel 0 when unknown.
+void host_sim_air_frame(const uint8_t *frame, size_t len, uint8_t channel, int8_t rssi);
+
+// Deliver an event to the registered esp_event handlers
+void host_sim_post_event(esp_event_base_t base, int32_t id, void *data);
+
+// Suppress ESP_LOGx output below level
+void host_sim_set_log_level(int level);
+
+// Load/save the simulated NVS contents, so a replay can start warm from an earlier one.
+// Loading a missing file leaves NVS empty and returns false.
+bool host_sim_nvs_load(const char *path);
+bool host_sim_nvs_save(const char *path);
+
+// Number of nvs_commit calls that had changes to write
+uint32_t host_sim_nvs_commits(void);
@@ -0,0 +1,198 @@
+// Throughput of main/ie_parser.c on a corpus of captured frames. Every beacon and probe response
+// in the captures is parsed through mgmt_frame_ies and ie_parse like process_frame does (probe
+// requests are not parsed there, they are skipped), the result is ns per frame and MB/s of frame
+// bytes for each kind.
+//
+// Without arguments the corpus is host/captures/five_aps.pcap, the capture the replay test uses.
+// It is synthetic and its frames are short (only the beacons carry a vendor element), pass a
+// capture from a real neighbourhood for numbers that reflect one.
+//
+//   ie_parser_bench [-r rounds] [capture.pcap ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ie_parser.h"
+#include "pcap_file.h"
+
+#define FRAMES_PER_ROUND 1024  // frames parsed per round, the corpus is cycled through
+#define DEFAULT_ROUNDS 5000
+#define MAX_FRAME_LEN 2304     // largest 802.11 MSDU, longer records are skipped
+#define FCS_LEN 4
+
+typedef struct corpus_frame_t
+{
+    uint8_t *data;
+    size_t len;
+} corpus_frame_t;
+
+typedef struct corpus_t
+{
+    const char *name;
+    uint8_t subtype;
+    corpus_frame_t *frames;
+    size_t count;
+    size_t capacity;
+    size_t bytes;
+} corpus_t;
+
+static corpus_t corpora[] = {
+    {.name = "beacon", .subtype = FRAME_SUBTYPE_BEACON},
+    {.name = "probe resp", .subtype = FRAME_SUBTYPE_PROBE_RESP},
+};
+#define NUM_CORPORA (sizeof(corpora) / sizeof(corpora[0]))
+
+static void corpus_add(corpus_t *c, const uint8_t *frame, size_t len)
+{
+    if (c->count == c->capacity)
+    {
+        c->capacity = c->capacity ? c->capacity * 2 : 64;
+        c->frames = realloc(c->frames, c->capacity * sizeof(*c->frames));
+        if (!c->frames)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    corpus_frame_t *f = &c->frames[c->count++];
+    f->data = malloc(len);
+    if (!f->data)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    memcpy(f->data, frame, len);
+    f->len = len;
+    c->bytes += len;
+}
+
+// Sorts the management frames of one capture into the corpora, returns false if it cannot be read
+static bool load_capture(const char *path, unsigned *skipped)
+{
+    pcap_file_t pcap;
+    if (!pcap_open(&pcap, path))
+    {
+        return false;
+    }
+
+    static uint8_t rec_buf[MAX_FRAME_LEN + 512];
+    while (true)
+    {
+        pcap_frame_t f = {0};
+        bool malformed;
+        if (!pcap_next_frame(&pcap, rec_buf, sizeof(rec_buf), &f, &malformed))
+        {
+            break;
+        }
+        size_t len = f.len;
+        if (!malformed && f.has_fcs && len >= FCS_LEN)
+        {
+            len -= FCS_LEN;
+        }
+
+        corpus_t *c = NULL;
+        for (size_t i = 0; !malformed && len >= 1 && i < NUM_CORPORA; i++)
+        {
+            if ((f.frame[0] & 0xFC) == corpora[i].subtype)
+            {
+                c = &corpora[i];
+            }
+        }
+        if (c && len <= MAX_FRAME_LEN)
+        {
+            corpus_add(c, f.frame, len);
+        }
+        else
+        {
+            *skipped += 1;
+        }
+    }
+    pcap_close(&pcap);
+    return true;
+}
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Sum of what was parsed, so the compiler cannot drop the work
+static uint32_t sink;
+
+static void parse_frames(const corpus_t *c, unsigned rounds)
+{
+    size_t next = 0;
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < FRAMES_PER_ROUND; i++)
+        {
+            const corpus_frame_t *f = &c->frames[next];
+            next = next + 1 < c->count ? next + 1 : 0;
+
+            size_t ies_len;
+            const uint8_t *ies = mgmt_frame_ies(f->data, f->len, &ies_len);
+            mgmt_ies_t parsed;
+            ie_parse(ies, ies_len, &parsed);
+            sink += parsed.ssid.len + parsed.ds_channel + (parsed.rsn.data != NULL);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned rounds = DEFAULT_ROUNDS;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:")) != -1)
+    {
+        if (opt != 'r' || (rounds = (unsigned)strtoul(optarg, NULL, 0)) == 0)
+        {
+            fprintf(stderr, "usage: %s [-r rounds] [capture.pcap ...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static const char *default_captures[] = {IE_BENCH_CAPTURE};
+    const char **captures = optind < argc ? (const char **)argv + optind : default_captures;
+    int num_captures = optind < argc ? argc - optind : 1;
+
+    unsigned skipped = 0;
+    for (int i = 0; i < num_captures; i++)
+    {
+        if (!load_capture(captures[i], &skipped))
+        {
+            return 1;
+        }
+    }
+
+    printf("%u x %d frames each, %u other frames skipped\n", rounds, FRAMES_PER_ROUND, skipped);
+    printf("frame       count  avg bytes    ns/frame      MB/s\n");
+    for (size_t i = 0; i < NUM_CORPORA; i++)
+    {
+        const corpus_t *c = &corpora[i];
+        if (!c->count)
+        {
+            printf("%-10s %6u\n", c->name, 0u);
+            continue;
+        }
+
+        // the best of three runs, so a preempted run does not count
+        double best = 0;
+        for (int attempt = 0; attempt < 3; attempt++)
+        {
+            double start = now_ns();
+            parse_frames(c, rounds);
+            double ns = (now_ns() - start) / ((double)rounds * FRAMES_PER_ROUND);
+            if (attempt == 0 || ns < best)
+            {
+                best = ns;
+            }
+        }
+        double avg_len = (double)c->bytes / c->count;
+        printf("%-10s %6zu %10.1f %11.1f %9.0f\n", c->name, c->count, avg_len, best, avg_len / best * 1e3);
+    }
+    return sink ? 0 : 1;
+}
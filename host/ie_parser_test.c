@@ -0,0 +1,256 @@
+// Unit tests for main/ie_parser.c: malformed element lists must end the walk without reading past
+// the buffer, and the elements in front of the damage must still come out. Every test frame is
+// copied to the end of a heap block before parsing, so an overread shows up under ASan/valgrind.
+//
+//   ie_parser_test    exits 0 when every check passes
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ie_parser.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if (!(cond))                                                                 \
+        {                                                                            \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures += 1;                                                           \
+        }                                                                            \
+    } while (0)
+
+// Copy of len bytes that ends exactly at the end of its allocation
+static const uint8_t *tail_copy(const uint8_t *data, size_t len)
+{
+    static uint8_t *block = NULL;
+    free(block);
+    block = malloc(len ? len : 1);
+    if (len)
+    {
+        memcpy(block, data, len);
+    }
+    return block;
+}
+
+static void parse(const uint8_t *ies, size_t len, mgmt_ies_t *out)
+{
+    ie_parse(tail_copy(ies, len), len, out);
+}
+
+static void test_iter_exact_end()
+{
+    const uint8_t ies[] = {IE_SSID, 2, 'a', 'b', IE_DS_PARAMS, 1, 6};
+    ie_iter_t it;
+    ie_view_t ie;
+    ie_iter_init(&it, tail_copy(ies, sizeof(ies)), sizeof(ies));
+
+    CHECK(ie_iter_next(&it, &ie) && ie.id == IE_SSID && ie.len == 2 && memcmp(ie.data, "ab", 2) == 0);
+    CHECK(ie_iter_next(&it, &ie) && ie.id == IE_DS_PARAMS && ie.len == 1 && ie.data[0] == 6);
+    CHECK(!ie_iter_next(&it, &ie));
+    CHECK(!it.truncated);
+}
+
+static void test_iter_empty()
+{
+    ie_iter_t it;
+    ie_view_t ie;
+    ie_iter_init(&it, tail_copy(NULL, 0), 0);
+    CHECK(!ie_iter_next(&it, &ie));
+    CHECK(!it.truncated);
+}
+
+static void test_iter_lone_id_byte()
+{
+    // the header of the next element is cut off after its id
+    const uint8_t ies[] = {IE_SSID, 0, IE_RSN};
+    ie_iter_t it;
+    ie_view_t ie;
+    ie_iter_init(&it, tail_copy(ies, sizeof(ies)), sizeof(ies));
+
+    CHECK(ie_iter_next(&it, &ie) && ie.id == IE_SSID && ie.len == 0);
+    CHECK(!ie_iter_next(&it, &ie));
+    CHECK(it.truncated);
+}
+
+static void test_iter_length_overrun()
+{
+    // the RSN element claims 20 bytes, only 4 follow
+    const uint8_t ies[] = {IE_SUPPORTED_RATES, 1, 0x82, IE_RSN, 20, 1, 0, 0, 0};
+    ie_iter_t it;
+    ie_view_t ie;
+    ie_iter_init(&it, tail_copy(ies, sizeof(ies)), sizeof(ies));
+
+    CHECK(ie_iter_next(&it, &ie) && ie.id == IE_SUPPORTED_RATES);
+    CHECK(!ie_iter_next(&it, &ie));
+    CHECK(it.truncated);
+    // a failed step must not move on, a second call fails the same way
+    CHECK(!ie_iter_next(&it, &ie));
+}
+
+static void test_iter_max_length()
+{
+    uint8_t ies[2 + 255];
+    memset(ies, 0x5A, sizeof(ies));
+    ies[0] = 221;
+    ies[1] = 255;
+    ie_iter_t it;
+    ie_view_t ie;
+    ie_iter_init(&it, tail_copy(ies, sizeof(ies)), sizeof(ies));
+
+    CHECK(ie_iter_next(&it, &ie) && ie.id == 221 && ie.len == 255);
+    CHECK(!ie_iter_next(&it, &ie));
+    CHECK(!it.truncated);
+
+    // one byte short of the same element
+    ie_iter_init(&it, tail_copy(ies, sizeof(ies) - 1), sizeof(ies) - 1);
+    CHECK(!ie_iter_next(&it, &ie));
+    CHECK(it.truncated);
+}
+
+static void test_parse_zero_length_ssid()
+{
+    const uint8_t ies[] = {IE_SSID, 0, IE_SUPPORTED_RATES, 1, 0x82};
+    mgmt_ies_t out;
+    parse(ies, sizeof(ies), &out);
+
+    // present but empty, unlike a missing SSID element
+    CHECK(out.ssid.data != NULL);
+    CHECK(out.ssid.len == 0);
+    CHECK(out.rates.data && out.rates.len == 1);
+    CHECK(!out.truncated);
+}
+
+static void test_parse_missing_elements()
+{
+    const uint8_t ies[] = {IE_SUPPORTED_RATES, 1, 0x82};
+    mgmt_ies_t out;
+    parse(ies, sizeof(ies), &out);
+
+    CHECK(out.ssid.data == NULL);
+    CHECK(out.rsn.data == NULL);
+    CHECK(out.ht_caps.data == NULL);
+    CHECK(out.ds_channel == 0);
+    CHECK(out.dtim_period == 0);
+}
+
+static void test_parse_first_ssid_wins()
+{
+    const uint8_t ies[] = {IE_SSID, 3, 'o', 'n', 'e', IE_SSID, 3, 't', 'w', 'o'};
+    mgmt_ies_t out;
+    parse(ies, sizeof(ies), &out);
+
+    CHECK(out.ssid.len == 3 && memcmp(out.ssid.data, "one", 3) == 0);
+}
+
+static void test_parse_short_fixed_elements()
+{
+    // DS Parameter Set and TIM too short to hold the fields we read
+    const uint8_t ies[] = {IE_DS_PARAMS, 0, IE_TIM, 2, 0, 3};
+    mgmt_ies_t out;
+    parse(ies, sizeof(ies), &out);
+
+    CHECK(out.ds_channel == 0);
+    CHECK(out.dtim_period == 0);
+    CHECK(!out.truncated);
+}
+
+static void test_parse_vendor_elements()
+{
+    // WMM and WPS vendor elements around the ones we keep, the parser skips them by length
+    const uint8_t ies[] = {
+        IE_SSID, 4, 'h', 'o', 'm', 'e',
+        221, 7, 0x00, 0x50, 0xF2, 0x02, 0x01, 0x01, 0x00,              // WMM
+        IE_RSN, 2, 1, 0,
+        221, 9, 0x00, 0x50, 0xF2, 0x04, 0x10, 0x4A, 0x00, 0x01, 0x10, // WPS
+        221, 0,                                                        // empty vendor element
+        IE_HT_CAPS, 2, 0xEF, 0x01,
+        IE_DS_PARAMS, 1, 11,
+    };
+    mgmt_ies_t out;
+    parse(ies, sizeof(ies), &out);
+
+    CHECK(out.ssid.len == 4 && memcmp(out.ssid.data, "home", 4) == 0);
+    CHECK(out.rsn.data && out.rsn.len == 2);
+    CHECK(out.ht_caps.data && out.ht_caps.len == 2 && out.ht_caps.data[0] == 0xEF);
+    CHECK(out.ds_channel == 11);
+    CHECK(!out.truncated);
+}
+
+static void test_parse_truncated_vendor_element()
+{
+    // capture cut off inside a vendor element: what came before it survives
+    const uint8_t ies[] = {IE_SSID, 2, 'a', 'p', IE_DS_PARAMS, 1, 6, 221, 30, 0x00, 0x50, 0xF2};
+    mgmt_ies_t out;
+    parse(ies, sizeof(ies), &out);
+
+    CHECK(out.ssid.len == 2);
+    CHECK(out.ds_channel == 6);
+    CHECK(out.truncated);
+}
+
+static void test_frame_ies()
+{
+    uint8_t frame[MGMT_HDR_LEN + MGMT_FIXED_LEN + 4];
+    memset(frame, 0, sizeof(frame));
+    size_t ies_len;
+
+    // probe request: elements right after the header
+    frame[0] = FRAME_SUBTYPE_PROBE_REQ;
+    const uint8_t *ies = mgmt_frame_ies(frame, sizeof(frame), &ies_len);
+    CHECK(ies == frame + MGMT_HDR_LEN && ies_len == sizeof(frame) - MGMT_HDR_LEN);
+
+    // beacon and probe response: after the fixed fields
+    frame[0] = FRAME_SUBTYPE_BEACON;
+    ies = mgmt_frame_ies(frame, sizeof(frame), &ies_len);
+    CHECK(ies == frame + MGMT_HDR_LEN + MGMT_FIXED_LEN && ies_len == 4);
+    frame[0] = FRAME_SUBTYPE_PROBE_RESP;
+    ies = mgmt_frame_ies(frame, sizeof(frame), &ies_len);
+    CHECK(ies == frame + MGMT_HDR_LEN + MGMT_FIXED_LEN && ies_len == 4);
+
+    // a beacon with exactly the fixed fields has an empty element list
+    frame[0] = FRAME_SUBTYPE_BEACON;
+    ies = mgmt_frame_ies(frame, MGMT_HDR_LEN + MGMT_FIXED_LEN, &ies_len);
+    CHECK(ies && ies_len == 0);
+
+    // too short for the header or the fixed fields
+    CHECK(mgmt_frame_ies(frame, MGMT_HDR_LEN - 1, &ies_len) == NULL);
+    CHECK(mgmt_frame_ies(frame, MGMT_HDR_LEN + MGMT_FIXED_LEN - 1, &ies_len) == NULL);
+}
+
+static void test_beacon_interval()
+{
+    uint8_t frame[MGMT_HDR_LEN + MGMT_FIXED_LEN];
+    memset(frame, 0, sizeof(frame));
+    frame[MGMT_HDR_LEN + 8] = 0x64; // 100 TU, little endian
+    frame[MGMT_HDR_LEN + 9] = 0x00;
+
+    CHECK(mgmt_beacon_interval(frame, sizeof(frame)) == 100);
+    CHECK(mgmt_beacon_interval(frame, sizeof(frame) - 1) == 0);
+}
+
+int main()
+{
+    test_iter_exact_end();
+    test_iter_empty();
+    test_iter_lone_id_byte();
+    test_iter_length_overrun();
+    test_iter_max_length();
+    test_parse_zero_length_ssid();
+    test_parse_missing_elements();
+    test_parse_first_ssid_wins();
+    test_parse_short_fixed_elements();
+    test_parse_vendor_elements();
+    test_parse_truncated_vendor_element();
+    test_frame_ies();
+    test_beacon_interval();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("ie_parser: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <string.h>
+#include "pcap_file.h"
+
+#define PCAP_MAGIC_USEC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+
+#define RADIOTAP_FLAGS_FCS 0x10
+
+static inline uint16_t rd16le(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t rd32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t pcap_u32(const pcap_file_t *pcap, uint32_t v)
+{
+    return pcap->swapped ? __builtin_bswap32(v) : v;
+}
+
+static uint8_t freq_to_channel(uint16_t mhz)
+{
+    if (mhz == 2484)
+    {
+        return 14;
+    }
+    if (mhz >= 2412 && mhz <= 2472)
+    {
+        return (uint8_t)((mhz - 2407) / 5);
+    }
+    return 0xFF; // not a 2.4 GHz channel, never matches the radio
+}
+
+bool pcap_open(pcap_file_t *pcap, const char *path)
+{
+    uint32_t hdr[6];
+
+    pcap->fp = fopen(path, "rb");
+    if (!pcap->fp)
+    {
+        perror(path);
+        return false;
+    }
+    if (fread(hdr, sizeof(hdr), 1, pcap->fp) != 1)
+    {
+        fprintf(stderr, "%s: short pcap header\n", path);
+        return false;
+    }
+
+    uint32_t magic = hdr[0];
+    pcap->swapped = (magic == __builtin_bswap32(PCAP_MAGIC_USEC) || magic == __builtin_bswap32(PCAP_MAGIC_NSEC));
+    magic = pcap_u32(pcap, magic);
+    if (magic != PCAP_MAGIC_USEC && magic != PCAP_MAGIC_NSEC)
+    {
+        fprintf(stderr, "%s: not a pcap file (pcapng is not supported)\n", path);
+        return false;
+    }
+    pcap->nsec = (magic == PCAP_MAGIC_NSEC);
+    pcap->linktype = pcap_u32(pcap, hdr[5]) & 0x0FFFFFFF;
+    if (pcap->linktype != LINKTYPE_IEEE802_11 && pcap->linktype != LINKTYPE_IEEE802_11_RADIOTAP)
+    {
+        fprintf(stderr, "%s: unsupported link type %u\n", path, (unsigned)pcap->linktype);
+        return false;
+    }
+    return true;
+}
+
+// Reads the next record into buf. Returns false at end of file.
+static bool pcap_next_record(pcap_file_t *pcap, uint8_t *buf, size_t buf_size, int64_t *ts_us, size_t *len)
+{
+    uint32_t rec[4];
+    if (fread(rec, sizeof(rec), 1, pcap->fp) != 1)
+    {
+        return false;
+    }
+
+    uint32_t sec = pcap_u32(pcap, rec[0]);
+    uint32_t frac = pcap_u32(pcap, rec[1]);
+    uint32_t incl_len = pcap_u32(pcap, rec[2]);
+
+    *ts_us = (int64_t)sec * 1000000 + (pcap->nsec ? frac / 1000 : frac);
+    *len = incl_len < buf_size ? incl_len : buf_size;
+    if (fread(buf, 1, *len, pcap->fp) != *len)
+    {
+        return false;
+    }
+    if (incl_len > *len)
+    {
+        fseek(pcap->fp, incl_len - *len, SEEK_CUR);
+    }
+    return true;
+}
+
+// Pulls flags, channel and antenna signal out of the radiotap header.
+// Only the first present word is decoded, the fields we need all live there.
+static bool parse_radiotap(const uint8_t *buf, size_t len, pcap_frame_t *f)
+{
+    static const uint8_t field_align[] = {8, 1, 1, 2, 2, 1}; // TSFT, flags, rate, channel, FHSS, dBm signal
+    static const uint8_t field_size[] = {8, 1, 1, 4, 2, 1};
+
+    if (len < 8)
+    {
+        return false;
+    }
+    uint16_t rt_len = rd16le(buf + 2);
+    if (rt_len < 8 || rt_len > len)
+    {
+        return false;
+    }
+
+    uint32_t present = rd32le(buf + 4);
+    size_t off = 8;
+    for (uint32_t word = present; word & (1u << 31); off += 4)
+    {
+        if (off + 4 > rt_len)
+        {
+            return false;
+        }
+        word = rd32le(buf + off);
+    }
+
+    for (int bit = 0; bit < (int)sizeof(field_size); bit++)
+    {
+        if (!(present & (1u << bit)))
+        {
+            continue;
+        }
+        off = (off + field_align[bit] - 1) & ~(size_t)(field_align[bit] - 1);
+        if (off + field_size[bit] > rt_len)
+        {
+            return false;
+        }
+        switch (bit)
+        {
+        case 1:
+            f->has_fcs = buf[off] & RADIOTAP_FLAGS_FCS;
+            break;
+        case 3:
+            f->channel = freq_to_channel(rd16le(buf + off));
+            break;
+        case 5:
+            f->rssi = (int8_t)buf[off];
+            break;
+        }
+        off += field_size[bit];
+    }
+
+    f->frame = buf + rt_len;
+    f->len = len - rt_len;
+    return true;
+}
+
+void pcap_close(pcap_file_t *pcap)
+{
+    if (pcap->fp)
+    {
+        fclose(pcap->fp);
+        pcap->fp = NULL;
+    }
+}
+
+bool pcap_next_frame(pcap_file_t *pcap, uint8_t *buf, size_t buf_size, pcap_frame_t *f, bool *malformed)
+{
+    size_t len;
+    if (!pcap_next_record(pcap, buf, buf_size, &f->ts_us, &len))
+    {
+        return false;
+    }
+    f->frame = buf;
+    f->len = len;
+    f->has_fcs = false;
+    *malformed = pcap->linktype == LINKTYPE_IEEE802_11_RADIOTAP && !parse_radiotap(buf, len, f);
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Reader for pcap captures of 802.11 frames, used by pcap_replay.c and ie_parser_bench.c.
+// Supports LINKTYPE_IEEE802_11_RADIOTAP (channel, RSSI and FCS flag are taken from the radiotap
+// header) and LINKTYPE_IEEE802_11. pcapng is not supported.
+
+#define LINKTYPE_IEEE802_11 105
+#define LINKTYPE_IEEE802_11_RADIOTAP 127
+
+typedef struct pcap_file_t
+{
+    FILE *fp;
+    bool swapped;
+    bool nsec;
+    uint32_t linktype;
+} pcap_file_t;
+
+typedef struct pcap_frame_t
+{
+    int64_t ts_us;
+    const uint8_t *frame; // 802.11 header onwards
+    size_t len;
+    bool has_fcs;
+    uint8_t channel; // 0 when the capture does not say, 0xFF for a channel outside 2.4 GHz
+    int8_t rssi;
+} pcap_frame_t;
+
+// Prints what is wrong with the file to stderr and returns false if it cannot be read
+bool pcap_open(pcap_file_t *pcap, const char *path);
+void pcap_close(pcap_file_t *pcap);
+
+// Reads the next record into buf and points f into it. channel and rssi are only written when the
+// capture carries them, set them to the defaults beforehand. Returns false at the end of the file,
+// sets *malformed for a record whose radiotap header does not parse.
+bool pcap_next_frame(pcap_file_t *pcap, uint8_t *buf, size_t buf_size, pcap_frame_t *f, bool *malformed);
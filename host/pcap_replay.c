@@ -0,0 +1,229 @@
+// Replays a pcap capture through the promiscuous scanner in main/scan.c on a Linux host.
+//
+// scan.c is compiled into this translation unit so the driver can reach its static state and
+// run scan_rx_task's work synchronously: after each delivered frame and, through the task hook,
+// after each esp_timer callback. Time is simulated: each frame is delivered at its capture
+// timestamp, and the esp_timer callbacks that drive channel hopping fire in between, so a capture
+// replays much faster than real time. Frames are only delivered while the simulated radio is tuned
+// to the channel they were captured on.
+//
+// Captures are read by pcap_file.c. Frames of a LINKTYPE_IEEE802_11 capture carry no channel and
+// are treated as heard on the current one.
+
+#include "scan.c"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "host_sim.h"
+#include "pcap_file.h"
+
+#define REPLAY_MAX_FRAME 4096  // sig_len is a 12 bit field
+#define REPLAY_DEFAULT_RSSI -60
+#define REPLAY_TAIL_MS 5000    // how long to keep running timers after the last frame
+
+typedef struct replay_stats_t
+{
+    uint32_t read;
+    uint32_t delivered;
+    uint32_t off_channel;
+    uint32_t not_listening;
+    uint32_t malformed;
+} replay_stats_t;
+
+static wifi_promiscuous_pkt_type_t frame_pkt_type(const uint8_t *frame)
+{
+    switch ((frame[0] >> 2) & 0x3)
+    {
+    case 0:
+        return WIFI_PKT_MGMT;
+    case 1:
+        return WIFI_PKT_CTRL;
+    case 2:
+        return WIFI_PKT_DATA;
+    default:
+        return WIFI_PKT_MISC;
+    }
+}
+
+// Hands one frame to the promiscuous callback the way the driver would, then drains the ring
+static void deliver_frame(const pcap_frame_t *f, replay_stats_t *stats)
+{
+    static uint8_t pkt_buf[sizeof(wifi_promiscuous_pkt_t) + REPLAY_MAX_FRAME + FRAME_FCS_LEN];
+
+    // a driver scan hears the frame whatever promiscuous mode is doing
+    host_sim_air_frame(f->frame, f->len, f->channel, f->rssi);
+
+    wifi_promiscuous_cb_t cb = host_sim_rx_cb();
+    if (!cb)
+    {
+        stats->not_listening += 1;
+        return;
+    }
+    if (f->channel && f->channel != host_sim_channel())
+    {
+        stats->off_channel += 1;
+        return;
+    }
+
+    // the driver reports sig_len with the FCS included, add a dummy one if the capture stripped it
+    size_t sig_len = f->len + (f->has_fcs ? 0 : FRAME_FCS_LEN);
+    if (f->len < 2 || sig_len > REPLAY_MAX_FRAME)
+    {
+        stats->malformed += 1;
+        return;
+    }
+
+    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)pkt_buf;
+    memset(&pkt->rx_ctrl, 0, sizeof(pkt->rx_ctrl));
+    pkt->rx_ctrl.rssi = f->rssi;
+    pkt->rx_ctrl.channel = host_sim_channel();
+    pkt->rx_ctrl.sig_len = sig_len;
+    pkt->rx_ctrl.timestamp = (uint32_t)f->ts_us;
+    memcpy(pkt->payload, f->frame, f->len);
+    memset(pkt->payload + f->len, 0, sig_len - f->len);
+
+    cb(pkt, frame_pkt_type(f->frame));
+    scan_rx_drain();
+    stats->delivered += 1;
+}
+
+static bool parse_backend(const char *name)
+{
+    for (int backend = 0; backend < SCAN_BACKEND_COUNT; backend++)
+    {
+        if (strcmp(name, scan_backend_name((scan_backend_t)backend)) == 0)
+        {
+            scan_engine_set_backend((scan_backend_t)backend);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-q] [-o offset_ms] [-t tail_ms] [-n nvs.bin] [-b backend] capture.pcap\n"
+            "  -q            only print scan results and replay stats\n"
+            "  -o offset_ms  simulated time of the first frame after boot (default 0)\n"
+            "  -t tail_ms    keep running timers this long after the last frame (default %d)\n"
+            "  -n nvs.bin    load NVS from this file before boot (if it exists) and save it at the end,\n"
+            "                so a second replay starts from the sweep history of the first\n"
+            "  -b backend    probe, sniff or driver (default %s), see scan_engine.h\n",
+            prog, REPLAY_TAIL_MS, scan_backend_name(SCAN_BACKEND));
+}
+
+int main(int argc, char **argv)
+{
+    int64_t offset_us = 0;
+    int64_t tail_us = (int64_t)REPLAY_TAIL_MS * 1000;
+    const char *nvs_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "qo:t:n:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'q':
+            host_sim_set_log_level(ESP_LOG_WARN);
+            break;
+        case 'o':
+            offset_us = atoll(optarg) * 1000;
+            break;
+        case 't':
+            tail_us = atoll(optarg) * 1000;
+            break;
+        case 'n':
+            nvs_path = optarg;
+            break;
+        case 'b':
+            if (!parse_backend(optarg))
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    pcap_file_t pcap;
+    if (!pcap_open(&pcap, argv[optind]))
+    {
+        return 1;
+    }
+
+    if (nvs_path)
+    {
+        host_sim_nvs_load(nvs_path);
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    host_sim_set_task_hook(scan_rx_drain);
+    app_main();
+    scan_rx_drain(); // the first sweep is posted to scan_rx_task
+
+    static uint8_t rec_buf[REPLAY_MAX_FRAME + 512];
+    replay_stats_t stats = {0};
+    int64_t first_ts = -1;
+
+    while (true)
+    {
+        pcap_frame_t f = {.channel = 0, .rssi = REPLAY_DEFAULT_RSSI};
+        bool malformed;
+        if (!pcap_next_frame(&pcap, rec_buf, sizeof(rec_buf), &f, &malformed))
+        {
+            break;
+        }
+        stats.read += 1;
+        if (first_ts < 0)
+        {
+            first_ts = f.ts_us;
+        }
+        if (malformed)
+        {
+            stats.malformed += 1;
+            continue;
+        }
+
+        f.ts_us = f.ts_us - first_ts + offset_us;
+        host_sim_advance_to(f.ts_us);
+        deliver_frame(&f, &stats);
+    }
+    pcap_close(&pcap);
+
+    // let the channel-hop timers run out the sweep
+    int64_t end_us = esp_timer_get_time() + tail_us;
+    int64_t next_us;
+    while (host_sim_next_timer(&next_us) && next_us <= end_us)
+    {
+        host_sim_advance_to(next_us);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+    if (nvs_path && !host_sim_nvs_save(nvs_path))
+    {
+        perror(nvs_path);
+    }
+    double wall_ms = (wall_end.tv_sec - wall_start.tv_sec) * 1e3 + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e6;
+    double sim_ms = esp_timer_get_time() / 1e3;
+
+    printf("REPLAY: %u frames read, %u delivered, %u off channel, %u while not listening, %u malformed\n",
+           (unsigned)stats.read, (unsigned)stats.delivered, (unsigned)stats.off_channel,
+           (unsigned)stats.not_listening, (unsigned)stats.malformed);
+    printf("REPLAY: %u probes sent, %.1f ms simulated in %.1f ms wall (%.0fx real time)\n",
+           (unsigned)host_sim_tx_count(), sim_ms, wall_ms, wall_ms > 0 ? sim_ms / wall_ms : 0.0);
+    printf("REPLAY: %u NVS commits\n", (unsigned)host_sim_nvs_commits());
+    return 0;
+}
@@ -0,0 +1,39 @@
+# Replay regression test, run by ctest (see CMakeLists.txt):
+#   cmake -DREPLAY=<pcap_replay> -DBACKEND=<backend> -DCAPTURE=<capture.pcap> -DEXPECTED=<file> -P replay_check.cmake
+# Replays CAPTURE and compares the BSSIDs of the first snapshot, sorted, and its entry count with
+# EXPECTED. Only those are compared: RSSI averages, timings and the trace move with every change to
+# the dwell logic, the set of BSSIDs a capture yields should not.
+#
+# captures/five_aps.pcap: 1.8 s of radiotap frames from five APs on channels 1, 6 and 11, a probe
+# response every 100 ms and a beacon every 200 ms from each (one AP is hidden, one has a transmitter
+# address that differs from its BSSID), and probe requests from a client on 1 and 6 that must not
+# end up in the table. Every backend sees the same five BSSIDs.
+
+execute_process(COMMAND ${REPLAY} -q -b ${BACKEND} ${CAPTURE}
+                OUTPUT_VARIABLE output
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "pcap_replay exited with ${result}")
+endif()
+
+string(REPLACE "\n" ";" lines "${output}")
+set(bssids "")
+set(summary "")
+foreach(line IN LISTS lines)
+    if(summary STREQUAL "" AND line MATCHES "^=([0-9a-f]+) ")
+        list(APPEND bssids "=${CMAKE_MATCH_1}")
+    elseif(summary STREQUAL "" AND line MATCHES "^SNAPSHOT ")
+        set(summary "${line}")
+    endif()
+endforeach()
+list(SORT bssids)
+list(APPEND bssids "${summary}")
+string(REPLACE ";" "\n" actual "${bssids}")
+
+file(READ ${EXPECTED} expected)
+string(STRIP "${expected}" expected)
+if(NOT actual STREQUAL expected)
+    message(FATAL_ERROR "${BACKEND} replay of ${CAPTURE} differs from ${EXPECTED}\n"
+                        "expected:\n${expected}\nactual:\n${actual}")
+endif()
+message(STATUS "${BACKEND}: ${summary}")
@@ -0,0 +1,212 @@
+// Decodes binary scan result batches (see main/include/result_codec.h) from a capture of the
+// device's serial output, or pcap_replay output of a firmware built with RESULT_REPORT_BINARY.
+// Log lines around the batches are skipped, batches are found by their magic and checked by CRC.
+//
+//   result_decode [-t] [capture.bin]
+//     -t  apply the deltas in order and print the reconstructed table at the end
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "result_decoder.h"
+
+#define MIRROR_MAX 256 // BSSIDs tracked by -t, more than any device table holds
+
+typedef struct mirror_t
+{
+    result_record_t entries[MIRROR_MAX];
+    size_t count;
+} mirror_t;
+
+static void print_record(const result_record_t *rec)
+{
+    printf("%c%02x%02x%02x%02x%02x%02x", rec->op, rec->bssid[0], rec->bssid[1], rec->bssid[2],
+           rec->bssid[3], rec->bssid[4], rec->bssid[5]);
+    if (rec->op != '-')
+    {
+        printf(" %u %d %x sweep %u", rec->channel, rec->rssi, rec->flags, rec->last_sweep);
+        if (rec->samples)
+        {
+            printf(" avg %d min %d max %d n %u seen %u-%u ms", rec->rssi_avg, rec->rssi_min, rec->rssi_max,
+                   rec->samples, (unsigned)rec->first_seen_ms, (unsigned)rec->last_seen_ms);
+        }
+        if (rec->op != '~')
+        {
+            printf(" %s", rec->ssid);
+        }
+    }
+    putchar('\n');
+}
+
+static result_record_t *mirror_find(mirror_t *mirror, const uint8_t *bssid)
+{
+    for (size_t i = 0; i < mirror->count; i++)
+    {
+        if (memcmp(mirror->entries[i].bssid, bssid, 6) == 0)
+        {
+            return &mirror->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void mirror_apply(mirror_t *mirror, const result_record_t *rec)
+{
+    result_record_t *cur = mirror_find(mirror, rec->bssid);
+    switch (rec->op)
+    {
+    case '-':
+        if (cur)
+        {
+            *cur = mirror->entries[--mirror->count];
+        }
+        break;
+    case '~':
+        if (cur)
+        {
+            // changes do not repeat the SSID
+            cur->channel = rec->channel;
+            cur->rssi = rec->rssi;
+            cur->flags = rec->flags;
+            cur->last_sweep = rec->last_sweep;
+            cur->rssi_avg = rec->rssi_avg;
+            cur->rssi_min = rec->rssi_min;
+            cur->rssi_max = rec->rssi_max;
+            cur->samples = rec->samples;
+            cur->first_seen_ms = rec->first_seen_ms;
+            cur->last_seen_ms = rec->last_seen_ms;
+        }
+        break;
+    default:
+        if (!cur && mirror->count < MIRROR_MAX)
+        {
+            cur = &mirror->entries[mirror->count++];
+        }
+        if (cur)
+        {
+            *cur = *rec;
+            cur->op = '=';
+        }
+        break;
+    }
+}
+
+static uint8_t *read_all(FILE *fp, size_t *len)
+{
+    size_t cap = 1 << 16;
+    size_t n = 0;
+    uint8_t *buf = malloc(cap);
+    size_t got;
+    while (buf && (got = fread(buf + n, 1, cap - n, fp)) > 0)
+    {
+        n += got;
+        if (n == cap)
+        {
+            cap *= 2;
+            uint8_t *grown = realloc(buf, cap);
+            if (!grown)
+            {
+                free(buf);
+                return NULL;
+            }
+            buf = grown;
+        }
+    }
+    *len = n;
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    bool table = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "t")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            table = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t] [capture.bin]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE *fp = stdin;
+    if (optind < argc)
+    {
+        fp = fopen(argv[optind], "rb");
+        if (!fp)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    size_t len;
+    uint8_t *buf = read_all(fp, &len);
+    if (fp != stdin)
+    {
+        fclose(fp);
+    }
+    if (!buf)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    static result_record_t records[MIRROR_MAX];
+    static mirror_t mirror;
+    unsigned batches = 0;
+    size_t batch_bytes = 0;
+
+    size_t pos = result_decode_find(buf, len, 0);
+    while (pos < len)
+    {
+        result_batch_t batch;
+        size_t consumed = 0;
+        result_decode_status_t status = result_decode_batch(buf + pos, len - pos, &batch, records, MIRROR_MAX, &consumed);
+
+        if (status != RESULT_DECODE_OK)
+        {
+            // not a batch after all (or a truncated one), look for the next magic
+            pos = result_decode_find(buf, len, pos + 1);
+            continue;
+        }
+
+        batches += 1;
+        batch_bytes += consumed;
+        printf("BATCH v%u %s sweep %u at %u ms, %u records, %zu bytes\n", batch.version,
+               batch.kind == RESULT_CODEC_KIND_SNAPSHOT ? "snapshot" : "delta", batch.sweep,
+               (unsigned)batch.time_ms, batch.count, consumed);
+
+        if (table && batch.kind == RESULT_CODEC_KIND_SNAPSHOT)
+        {
+            mirror.count = 0;
+        }
+        for (size_t i = 0; i < batch.count && i < MIRROR_MAX; i++)
+        {
+            print_record(&records[i]);
+            if (table)
+            {
+                mirror_apply(&mirror, &records[i]);
+            }
+        }
+        pos = result_decode_find(buf, len, pos + consumed);
+    }
+
+    if (table)
+    {
+        printf("TABLE: %zu BSSIDs\n", mirror.count);
+        for (size_t i = 0; i < mirror.count; i++)
+        {
+            print_record(&mirror.entries[i]);
+        }
+    }
+    printf("%u batches, %zu of %zu input bytes\n", batches, batch_bytes, len);
+
+    free(buf);
+    return batches ? 0 : 1;
+}
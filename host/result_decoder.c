@@ -0,0 +1,115 @@
+#include <string.h>
+#include "result_decoder.h"
+
+static inline uint16_t get16le(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get32le(const uint8_t *p)
+{
+    return (uint32_t)get16le(p) | ((uint32_t)get16le(p + 2) << 16);
+}
+
+size_t result_decode_find(const uint8_t *buf, size_t len, size_t from)
+{
+    for (size_t i = from; i + 1 < len; i++)
+    {
+        if (buf[i] == RESULT_CODEC_MAGIC0 && buf[i + 1] == RESULT_CODEC_MAGIC1)
+        {
+            return i;
+        }
+    }
+    return len;
+}
+
+result_decode_status_t result_decode_batch(const uint8_t *buf, size_t len, result_batch_t *batch,
+                                           result_record_t *records, size_t max_records, size_t *consumed)
+{
+    if (len < RESULT_CODEC_HEADER_LEN)
+    {
+        return RESULT_DECODE_SHORT;
+    }
+    if (buf[0] != RESULT_CODEC_MAGIC0 || buf[1] != RESULT_CODEC_MAGIC1 || buf[2] == 0)
+    {
+        return RESULT_DECODE_BAD;
+    }
+
+    batch->version = buf[2];
+    batch->kind = buf[3];
+    batch->sweep = get16le(buf + 4);
+    batch->count = get16le(buf + 6);
+    batch->time_ms = get32le(buf + 8);
+
+    if (batch->kind != RESULT_CODEC_KIND_DELTA && batch->kind != RESULT_CODEC_KIND_SNAPSHOT)
+    {
+        return RESULT_DECODE_BAD;
+    }
+
+    // from version 3 every record says how long it is, so a newer batch decodes to the fields we
+    // know and whatever it appended is skipped. Older records end where their known layout ends.
+    size_t prefix_len = batch->version >= 3 ? RESULT_CODEC_LEN_PREFIX : 0;
+    size_t stats_len = batch->version >= 2 ? RESULT_CODEC_STATS_LEN : 0;
+    size_t pos = RESULT_CODEC_HEADER_LEN;
+    for (uint16_t i = 0; i < batch->count; i++)
+    {
+        if (len < pos + prefix_len + RESULT_CODEC_RECORD_LEN)
+        {
+            return RESULT_DECODE_SHORT;
+        }
+        const uint8_t *rec = buf + pos + prefix_len;
+        uint8_t ssid_len = rec[12];
+        if (ssid_len > 32 || !strchr("+-~=", rec[0]) || rec[0] == 0)
+        {
+            return RESULT_DECODE_BAD;
+        }
+        size_t rec_len = RESULT_CODEC_RECORD_LEN + ssid_len + stats_len;
+        if (prefix_len)
+        {
+            if (buf[pos] < rec_len)
+            {
+                return RESULT_DECODE_BAD; // shorter than the fields its version promises
+            }
+            rec_len = buf[pos];
+        }
+        if (len < pos + prefix_len + rec_len)
+        {
+            return RESULT_DECODE_SHORT;
+        }
+
+        if (i < max_records)
+        {
+            result_record_t *out = &records[i];
+            out->op = (char)rec[0];
+            memcpy(out->bssid, rec + 1, 6);
+            out->channel = rec[7];
+            out->rssi = (int8_t)rec[8];
+            out->flags = rec[9];
+            out->last_sweep = get16le(rec + 10);
+            out->ssid_len = ssid_len;
+            memcpy(out->ssid, rec + RESULT_CODEC_RECORD_LEN, ssid_len);
+            out->ssid[ssid_len] = '\0';
+
+            // a v1 batch has no statistics, leave them zero (samples == 0 tells them apart)
+            const uint8_t *stats = rec + RESULT_CODEC_RECORD_LEN + ssid_len;
+            out->rssi_avg = stats_len ? (int8_t)stats[0] : 0;
+            out->rssi_min = stats_len ? (int8_t)stats[1] : 0;
+            out->rssi_max = stats_len ? (int8_t)stats[2] : 0;
+            out->samples = stats_len ? get16le(stats + 3) : 0;
+            out->first_seen_ms = stats_len ? get32le(stats + 5) : 0;
+            out->last_seen_ms = stats_len ? get32le(stats + 9) : 0;
+        }
+        pos += prefix_len + rec_len;
+    }
+
+    if (len < pos + RESULT_CODEC_TRAILER_LEN)
+    {
+        return RESULT_DECODE_SHORT;
+    }
+    if (get16le(buf + pos) != result_codec_crc16(buf, pos))
+    {
+        return RESULT_DECODE_BAD;
+    }
+    *consumed = pos + RESULT_CODEC_TRAILER_LEN;
+    return RESULT_DECODE_OK;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "result_codec.h"
+
+// Decoder for the binary scan result batches written by main/result_codec.c
+
+typedef struct result_batch_t
+{
+    uint8_t version;
+    uint8_t kind; // RESULT_CODEC_KIND_*
+    uint16_t sweep;
+    uint16_t count;
+    uint32_t time_ms;
+} result_batch_t;
+
+typedef struct result_record_t
+{
+    char op; // '+', '-', '~' or '='
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    uint8_t flags;
+    uint16_t last_sweep;
+    uint8_t ssid_len;
+    char ssid[33];
+    // RSSI statistics, version 2 and later, all zero before
+    int8_t rssi_avg;
+    int8_t rssi_min;
+    int8_t rssi_max;
+    uint16_t samples;
+    uint32_t first_seen_ms;
+    uint32_t last_seen_ms;
+} result_record_t;
+
+typedef enum
+{
+    RESULT_DECODE_OK,
+    RESULT_DECODE_SHORT, // buffer ends inside the batch, feed more bytes
+    RESULT_DECODE_BAD,   // no batch here: wrong magic, bad CRC or malformed record
+} result_decode_status_t;
+
+// Decode the batch at the start of buf into batch and up to max_records records (the rest are
+// validated and skipped). Batches newer than RESULT_CODEC_VERSION decode to the fields this
+// version knows. On OK *consumed is the size of the batch.
+result_decode_status_t result_decode_batch(const uint8_t *buf, size_t len, result_batch_t *batch,
+                                           result_record_t *records, size_t max_records, size_t *consumed);
+
+// Offset of the next possible batch start at or after from, len when there is none
+size_t result_decode_find(const uint8_t *buf, size_t len, size_t from);
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host stand-in for ESP-IDF's esp_attr.h, placement attributes mean nothing off-target
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
@@ -0,0 +1,206 @@
+// Checks that a sweep never touches the heap. The scanner is built into this program like in
+// pcap_replay.c, malloc/calloc/realloc/free are wrapped at link time (-Wl,--wrap, see
+// host/CMakeLists.txt) and counted once app_main has returned. Then several sweeps are run against a
+// synthetic neighbourhood of more APs than the table holds, so lookups, evictions, aging, delta
+// reports, the bulk table resets (RESULT_RESET_EVERY is lowered in host/CMakeLists.txt), the
+// history store and the connect all run, and any heap call fails the test.
+// Calls made inside libc itself (stdio buffers) are not wrapped and not counted.
+//
+//   sweep_alloc_test [probe|sniff|driver]
+
+#include "scan.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_sim.h"
+
+#define TEST_SWEEPS 6          // sweeps run to the end, enough for a history store (STORE_EVERY_SWEEPS)
+#define TEST_APS 64            // BSSIDs on the air, more than MAX_SCAN_RESULTS
+#define FRAME_GAP_US 5000      // one frame on the air every 5 ms
+#define TEST_LIMIT_US ((TEST_SWEEPS + 2) * (int64_t)(SCAN_INTERVAL + 10000) * 1000)
+
+#if RESULT_RESET_EVERY == 0 || RESULT_RESET_EVERY > TEST_SWEEPS
+#error "the results table has to be reset within TEST_SWEEPS sweeps"
+#endif
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static bool counting = false;
+static uint32_t heap_calls = 0;
+
+void *__wrap_malloc(size_t size)
+{
+    heap_calls += counting;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    heap_calls += counting;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    heap_calls += counting;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    heap_calls += counting;
+    __real_free(ptr);
+}
+
+// Beacon, or probe response to us, from AP ap. The APs spread over the 2.4 GHz channels, ap 0
+// carries the SSID we connect to.
+static size_t build_frame(uint8_t *frame, int ap, bool probe_resp)
+{
+    uint8_t channel = (uint8_t)(1 + ap % NUM_CHANNELS);
+    memset(frame, 0, MGMT_HDR_LEN + MGMT_FIXED_LEN);
+    frame[0] = probe_resp ? FRAME_SUBTYPE_PROBE_RESP : FRAME_SUBTYPE_BEACON;
+    if (probe_resp)
+    {
+        memcpy(frame + 4, probe_builder.mac, 6);
+    }
+    else
+    {
+        memset(frame + 4, 0xFF, 6);
+    }
+    const uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, (uint8_t)ap};
+    memcpy(frame + 10, bssid, 6);
+    memcpy(frame + 16, bssid, 6);
+    frame[MGMT_HDR_LEN + 8] = 0x64; // beacon interval 100 TU
+
+    size_t pos = MGMT_HDR_LEN + MGMT_FIXED_LEN;
+    char ssid[IE_SSID_MAX_LEN + 1];
+    int ssid_len = ap == 0 ? snprintf(ssid, sizeof(ssid), "%s", WIFI_SSID) : snprintf(ssid, sizeof(ssid), "ap-%d", ap);
+    frame[pos++] = IE_SSID;
+    frame[pos++] = (uint8_t)ssid_len;
+    memcpy(frame + pos, ssid, ssid_len);
+    pos += ssid_len;
+
+    const uint8_t rest[] = {
+        IE_SUPPORTED_RATES, 4, 0x82, 0x84, 0x8B, 0x96,
+        IE_DS_PARAMS, 1, channel,
+        IE_TIM, 4, 0, 1, 0, 0,
+        IE_RSN, 2, 1, 0,
+    };
+    memcpy(frame + pos, rest, sizeof(rest));
+    return pos + sizeof(rest);
+}
+
+// What the driver would hand the promiscuous callback for a frame from AP ap, if we are on its channel
+static void deliver(int ap, bool probe_resp)
+{
+    static uint8_t pkt_buf[sizeof(wifi_promiscuous_pkt_t) + 256];
+    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)pkt_buf;
+    uint8_t channel = (uint8_t)(1 + ap % NUM_CHANNELS);
+    int8_t rssi = (int8_t)(-40 - ap % 50);
+
+    size_t len = build_frame(pkt->payload, ap, probe_resp);
+    host_sim_air_frame(pkt->payload, len, channel, rssi);
+
+    wifi_promiscuous_cb_t cb = host_sim_rx_cb();
+    if (!cb || channel != host_sim_channel())
+    {
+        return;
+    }
+    memset(pkt->payload + len, 0, FRAME_FCS_LEN);
+    memset(&pkt->rx_ctrl, 0, sizeof(pkt->rx_ctrl));
+    pkt->rx_ctrl.rssi = rssi;
+    pkt->rx_ctrl.channel = channel;
+    pkt->rx_ctrl.sig_len = len + FRAME_FCS_LEN;
+    pkt->rx_ctrl.timestamp = (uint32_t)esp_timer_get_time();
+    cb(pkt, WIFI_PKT_MGMT);
+    scan_rx_drain();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [probe|sniff|driver]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2)
+    {
+        bool known = false;
+        for (int backend = 0; backend < SCAN_BACKEND_COUNT; backend++)
+        {
+            if (strcmp(argv[1], scan_backend_name((scan_backend_t)backend)) == 0)
+            {
+                scan_engine_set_backend((scan_backend_t)backend);
+                known = true;
+            }
+        }
+        if (!known)
+        {
+            fprintf(stderr, "unknown backend %s\n", argv[1]);
+            return 2;
+        }
+    }
+
+    host_sim_set_log_level(ESP_LOG_WARN);
+    host_sim_set_task_hook(scan_rx_drain);
+    app_main();
+    scan_rx_drain(); // the first sweep is posted to scan_rx_task
+
+    // boot may allocate (driver init does on the device too), sweeps may not
+    counting = true;
+    uint32_t first_resets = scan_results.resets;
+    uint16_t first_sweep = scan_sweep;
+    uint16_t last_sweep = first_sweep + TEST_SWEEPS - 1; // done once the sweep after it starts
+    uint32_t frames = 0;
+    int64_t next_frame_us = esp_timer_get_time();
+    while (scan_sweep <= last_sweep && esp_timer_get_time() < TEST_LIMIT_US)
+    {
+        int64_t next_us = next_frame_us;
+        int64_t timer_us;
+        if (host_sim_next_timer(&timer_us) && timer_us < next_us)
+        {
+            next_us = timer_us;
+        }
+        host_sim_advance_to(next_us);
+        if (next_us == next_frame_us)
+        {
+            // every fourth frame answers our probes
+            deliver(frames % TEST_APS, frames % 4 == 3);
+            frames += 1;
+            next_frame_us += FRAME_GAP_US;
+        }
+    }
+    counting = false;
+
+    unsigned sweeps = (unsigned)(scan_sweep - first_sweep);
+    unsigned resets = (unsigned)(scan_results.resets - first_resets);
+    printf("%s: %u sweeps, %u frames, %.1f s simulated, %u table resets, %u heap calls\n",
+           scan_backend_name(sweep_backend), sweeps, (unsigned)frames, esp_timer_get_time() / 1e6, resets,
+           (unsigned)heap_calls);
+    if (sweeps < TEST_SWEEPS)
+    {
+        fprintf(stderr, "only %u sweeps ran to the end\n", sweeps);
+        return 1;
+    }
+    if (resets < TEST_SWEEPS / RESULT_RESET_EVERY)
+    {
+        fprintf(stderr, "the table was reset %u times, expected %d\n", resets, TEST_SWEEPS / RESULT_RESET_EVERY);
+        return 1;
+    }
+    // the pool handed out entries again after the last reset
+    uint16_t in_table = result_table_count(&scan_results);
+    if (!in_table || result_pool_in_use(&scan_results.pool) != in_table)
+    {
+        fprintf(stderr, "pool holds %u entries, table %u\n", result_pool_in_use(&scan_results.pool), in_table);
+        return 1;
+    }
+    if (heap_calls)
+    {
+        fprintf(stderr, "sweeps made %u heap calls\n", (unsigned)heap_calls);
+        return 1;
+    }
+    return 0;
+}
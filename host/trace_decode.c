@@ -0,0 +1,348 @@
+// Decodes a scan trace dump (see main/include/scan_trace.h) into a per-channel timeline and
+// latency histograms. Reads a device log or pcap_replay output, everything that is not a
+// "T <seq> <time_us> <channel> <event> <arg>" line is ignored:
+//
+//   pcap_replay capture.pcap | trace_decode
+//   trace_decode monitor.log
+//
+// A visit starts when the sweep starts or the radio lands on a channel (CHAN_SWITCH) and ends
+// when it leaves (CHAN_LEAVE) or the sweep ends. Background sweeps also show the time back on the
+// associated AP's channel between off-channel windows (HOME_DWELL), marked with an H. For each
+// visit we report:
+//   switch   time from CHAN_LEAVE on the previous channel to CHAN_SWITCH on this one
+//   answer   time from the first probe sent to the first probe response addressed to us
+//   util     share of the dwell up to the last sign of activity (frame, discovery, answer)
+//   ext_ms   dwell the last extension asked for, ms from entering the channel
+// Frame counts and new BSSIDs are only traced when the firmware is built with SCAN_TRACE_FRAMES,
+// dwell extensions (ext) are the EVENTS level proxy for discoveries.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "scan_trace.h"
+
+#define HIST_BUCKETS 24  // log2 buckets, the last one collects everything above 2^22 us
+#define UTIL_BUCKETS 10  // 10% each
+
+typedef struct log_hist_t
+{
+    uint32_t counts[HIST_BUCKETS];
+    uint32_t total;
+} log_hist_t;
+
+typedef struct visit_t
+{
+    bool open;
+    bool home; // back on the AP's channel, not part of the sweep
+    uint8_t channel;
+    int64_t enter_us;
+    int64_t leave_us;        // CHAN_LEAVE of the previous visit, -1 if none
+    int64_t first_probe_us;  // -1 until a probe is sent
+    int64_t first_answer_us; // -1 until a response to us arrives
+    int64_t last_activity_us;
+    uint32_t probes;
+    uint32_t frames;
+    uint32_t found;   // needs SCAN_TRACE_FRAMES
+    uint32_t extends;
+    uint16_t extended_to_ms; // arg of the last DWELL_EXTENDED, 0 if never extended
+} visit_t;
+
+typedef struct decoder_t
+{
+    bool have_time;
+    uint32_t last_raw;
+    int64_t now_us; // record time unwrapped to 64 bits
+    visit_t visit;
+    int64_t pending_leave_us;
+    uint32_t records;
+    uint32_t unknown;
+    uint32_t visits;
+    log_hist_t switch_hist;
+    log_hist_t answer_hist;
+    uint32_t util_hist[UTIL_BUCKETS + 1];
+} decoder_t;
+
+static unsigned hist_bucket(int64_t us)
+{
+    unsigned bucket = 0;
+    while (bucket < HIST_BUCKETS - 1 && us >= ((int64_t)1 << bucket))
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+static void hist_add(log_hist_t *hist, int64_t us)
+{
+    hist->counts[hist_bucket(us)] += 1;
+    hist->total += 1;
+}
+
+static void print_bar(uint32_t count, uint32_t total)
+{
+    unsigned width = total ? (unsigned)((count * 40 + total - 1) / total) : 0;
+    for (unsigned i = 0; i < width; i++)
+    {
+        putchar('#');
+    }
+    putchar('\n');
+}
+
+static void print_hist(const char *title, const log_hist_t *hist)
+{
+    printf("\n%s (%u samples)\n", title, (unsigned)hist->total);
+    if (hist->total == 0)
+    {
+        return;
+    }
+    for (unsigned i = 0; i < HIST_BUCKETS; i++)
+    {
+        if (hist->counts[i] == 0)
+        {
+            continue;
+        }
+        long lo = i == 0 ? 0 : 1L << (i - 1);
+        if (i == HIST_BUCKETS - 1)
+        {
+            printf("  %8ld+        us %6u ", lo, (unsigned)hist->counts[i]);
+        }
+        else
+        {
+            printf("  %8ld-%-8ld us %6u ", lo, (1L << i) - 1, (unsigned)hist->counts[i]);
+        }
+        print_bar(hist->counts[i], hist->total);
+    }
+}
+
+static void print_util_hist(const decoder_t *dec)
+{
+    printf("\ndwell utilisation (%u visits)\n", (unsigned)dec->visits);
+    for (unsigned i = 0; i <= UTIL_BUCKETS; i++)
+    {
+        if (dec->util_hist[i] == 0)
+        {
+            continue;
+        }
+        if (i == UTIL_BUCKETS)
+        {
+            printf("      100%%    %6u ", (unsigned)dec->util_hist[i]);
+        }
+        else
+        {
+            printf("  %3u-%3u%%    %6u ", i * 10, i * 10 + 9, (unsigned)dec->util_hist[i]);
+        }
+        print_bar(dec->util_hist[i], dec->visits);
+    }
+}
+
+static void open_visit(decoder_t *dec, uint8_t channel, bool home)
+{
+    visit_t *v = &dec->visit;
+    memset(v, 0, sizeof(*v));
+    v->open = true;
+    v->home = home;
+    v->channel = channel;
+    v->enter_us = dec->now_us;
+    v->leave_us = dec->pending_leave_us;
+    v->first_probe_us = -1;
+    v->first_answer_us = -1;
+    v->last_activity_us = dec->now_us;
+    dec->pending_leave_us = -1;
+}
+
+static void close_visit(decoder_t *dec)
+{
+    visit_t *v = &dec->visit;
+    if (!v->open)
+    {
+        return;
+    }
+    v->open = false;
+
+    int64_t dwell = dec->now_us - v->enter_us;
+    int64_t active = v->last_activity_us - v->enter_us;
+    unsigned util = dwell > 0 ? (unsigned)(active * 100 / dwell) : 100;
+
+    printf("%3u%c %9.1f %8.1f ", v->channel, v->home ? 'H' : ' ', v->enter_us / 1000.0, dwell / 1000.0);
+    if (v->leave_us >= 0)
+    {
+        int64_t cost = v->enter_us - v->leave_us;
+        hist_add(&dec->switch_hist, cost);
+        printf("%9lld ", (long long)cost);
+    }
+    else
+    {
+        printf("%9s ", "-");
+    }
+    printf("%6u ", (unsigned)v->probes);
+    if (v->first_answer_us >= 0)
+    {
+        int64_t rtt = v->first_answer_us - v->first_probe_us;
+        hist_add(&dec->answer_hist, rtt);
+        printf("%9lld ", (long long)rtt);
+    }
+    else
+    {
+        printf("%9s ", "-");
+    }
+    if (v->home)
+    {
+        printf("%6s %5s %3s %5s %6s\n", "-", "-", "-", "-", "-");
+        return;
+    }
+    printf("%6u %5u %3u %4u%% ", (unsigned)v->frames, (unsigned)v->found, (unsigned)v->extends, util);
+    if (v->extends)
+    {
+        printf("%6u\n", (unsigned)v->extended_to_ms);
+    }
+    else
+    {
+        printf("%6s\n", "-");
+    }
+
+    dec->visits += 1;
+    dec->util_hist[util >= 100 ? UTIL_BUCKETS : util / 10] += 1;
+}
+
+static int parse_event(const char *name)
+{
+    for (int event = 1; event < TRACE_EVENT_COUNT; event++)
+    {
+        const char *known = scan_trace_event_name(event);
+        if (known && strcmp(known, name) == 0)
+        {
+            return event;
+        }
+    }
+    return -1;
+}
+
+static void decode_record(decoder_t *dec, uint32_t time_us, uint8_t channel, int event, uint16_t arg)
+{
+    // records carry the low 32 bits of esp_timer_get_time, unwrap them assuming no gap over ~71 min
+    if (dec->have_time)
+    {
+        dec->now_us += (uint32_t)(time_us - dec->last_raw);
+    }
+    else
+    {
+        dec->now_us = time_us;
+        dec->have_time = true;
+    }
+    dec->last_raw = time_us;
+
+    visit_t *v = &dec->visit;
+    switch (event)
+    {
+    case TRACE_SWEEP_START:
+        close_visit(dec);
+        dec->pending_leave_us = -1;
+        open_visit(dec, channel, false);
+        break;
+    case TRACE_CHAN_SWITCH:
+        close_visit(dec);
+        open_visit(dec, channel, false);
+        break;
+    case TRACE_HOME_DWELL:
+        close_visit(dec);
+        open_visit(dec, channel, true);
+        break;
+    case TRACE_CHAN_LEAVE:
+        close_visit(dec);
+        dec->pending_leave_us = dec->now_us;
+        break;
+    case TRACE_SWEEP_END:
+        close_visit(dec);
+        break;
+    case TRACE_PROBE_SENT:
+        v->probes += 1;
+        if (v->first_probe_us < 0)
+        {
+            v->first_probe_us = dec->now_us;
+        }
+        break;
+    case TRACE_PROBE_ANSWERED:
+        if (v->first_answer_us < 0 && v->first_probe_us >= 0)
+        {
+            v->first_answer_us = dec->now_us;
+        }
+        v->last_activity_us = dec->now_us;
+        break;
+    case TRACE_DWELL_EXTENDED:
+        // only a discovery extends the dwell
+        v->extends += 1;
+        v->extended_to_ms = arg;
+        v->last_activity_us = dec->now_us;
+        break;
+    case TRACE_RESULT_ADDED:
+        v->found += 1;
+        v->last_activity_us = dec->now_us;
+        break;
+    case TRACE_PROBE_REQ_RX:
+    case TRACE_PROBE_RESP_RX:
+    case TRACE_BEACON_RX:
+        v->frames += 1;
+        v->last_activity_us = dec->now_us;
+        break;
+    default:
+        break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    FILE *fp = stdin;
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-' && argv[1][1] != '\0'))
+    {
+        fprintf(stderr, "usage: %s [trace.log]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && strcmp(argv[1], "-") != 0)
+    {
+        fp = fopen(argv[1], "r");
+        if (!fp)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    static decoder_t dec;
+    dec.pending_leave_us = -1;
+
+    printf("chan  enter_ms dwell_ms switch_us probes answer_us frames found ext util ext_ms\n");
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp))
+    {
+        unsigned seq, time_us, channel, arg;
+        char name[32];
+        if (sscanf(line, "T %u %u %u %31s %u", &seq, &time_us, &channel, name, &arg) != 5)
+        {
+            continue;
+        }
+        dec.records += 1;
+
+        int event = parse_event(name);
+        if (event < 0)
+        {
+            dec.unknown += 1;
+            continue;
+        }
+        decode_record(&dec, time_us, (uint8_t)channel, event, (uint16_t)arg);
+    }
+    close_visit(&dec);
+
+    if (fp != stdin)
+    {
+        fclose(fp);
+    }
+
+    print_hist("channel switch cost", &dec.switch_hist);
+    print_hist("probe to first response", &dec.answer_hist);
+    print_util_hist(&dec);
+    printf("\n%u records, %u unknown events, %u visits\n",
+           (unsigned)dec.records, (unsigned)dec.unknown, (unsigned)dec.visits);
+    return dec.records ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include <stddef.h>
+#include "bssid_table.h"
+
+#define BSSID_TABLE_MASK (BSSID_TABLE_SLOTS - 1)
+
+_Static_assert((BSSID_TABLE_SLOTS & BSSID_TABLE_MASK) == 0, "BSSID_TABLE_SLOTS must be a power of two");
+
+// Fibonacci hashing, the top bits of key * 2^64/phi spread vendor-prefixed BSSIDs well
+static inline unsigned bssid_slot(uint64_t key)
+{
+    unsigned bits = __builtin_ctz(BSSID_TABLE_SLOTS);
+    return (unsigned)((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+void bssid_table_init(bssid_table_t *table)
+{
+    bssid_table_clear(table);
+}
+
+void bssid_table_clear(bssid_table_t *table)
+{
+    for (int i = 0; i < BSSID_TABLE_SLOTS; i++)
+    {
+        table->keys[i] = BSSID_KEY_EMPTY;
+        table->entries[i] = NULL;
+    }
+    table->count = 0;
+}
+
+scan_result_t *bssid_table_find(const bssid_table_t *table, uint64_t key)
+{
+    unsigned slot = bssid_slot(key);
+
+    // load factor is capped at 0.5, so there is always an empty slot to stop on
+    while (table->keys[slot] != BSSID_KEY_EMPTY)
+    {
+        if (table->keys[slot] == key)
+        {
+            return table->entries[slot];
+        }
+        slot = (slot + 1) & BSSID_TABLE_MASK;
+    }
+    return NULL;
+}
+
+bool bssid_table_insert(bssid_table_t *table, uint64_t key, scan_result_t *entry)
+{
+    if (table->count >= BSSID_TABLE_SLOTS / 2)
+    {
+        return false;
+    }
+
+    unsigned slot = bssid_slot(key);
+    while (table->keys[slot] != BSSID_KEY_EMPTY)
+    {
+        slot = (slot + 1) & BSSID_TABLE_MASK;
+    }
+    table->keys[slot] = key;
+    table->entries[slot] = entry;
+    table->count += 1;
+    return true;
+}
+
+scan_result_t *bssid_table_remove(bssid_table_t *table, uint64_t key)
+{
+    unsigned slot = bssid_slot(key);
+    while (table->keys[slot] != key)
+    {
+        if (table->keys[slot] == BSSID_KEY_EMPTY)
+        {
+            return NULL;
+        }
+        slot = (slot + 1) & BSSID_TABLE_MASK;
+    }
+    scan_result_t *removed = table->entries[slot];
+
+    // backward-shift deletion: pull later members of the probe run into the hole so
+    // lookups never need tombstones
+    unsigned hole = slot;
+    unsigned next = (hole + 1) & BSSID_TABLE_MASK;
+    while (table->keys[next] != BSSID_KEY_EMPTY)
+    {
+        unsigned home = bssid_slot(table->keys[next]);
+        // move next into the hole unless its home slot lies cyclically in (hole, next]
+        if (((next - home) & BSSID_TABLE_MASK) >= ((next - hole) & BSSID_TABLE_MASK))
+        {
+            table->keys[hole] = table->keys[next];
+            table->entries[hole] = table->entries[next];
+            hole = next;
+        }
+        next = (next + 1) & BSSID_TABLE_MASK;
+    }
+    table->keys[hole] = BSSID_KEY_EMPTY;
+    table->entries[hole] = NULL;
+    table->count -= 1;
+    return removed;
+}
+
+scan_result_t *bssid_table_next(const bssid_table_t *table, int *cursor)
+{
+    while (*cursor < BSSID_TABLE_SLOTS)
+    {
+        int slot = (*cursor)++;
+        if (table->keys[slot] != BSSID_KEY_EMPTY)
+        {
+            return table->entries[slot];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,53 @@
+#include "chan_sched.h"
+
+#define CHAN_SCHED_PRIOR (1 << 4) // one discovery's worth of score for 1/6/11
+
+void chan_sched_init(chan_sched_t *sched)
+{
+    for (int i = 0; i < CHAN_SCHED_MAX_CHANNELS; i++)
+    {
+        sched->score[i] = 0;
+    }
+    sched->score[1 - 1] = CHAN_SCHED_PRIOR;
+    sched->score[6 - 1] = CHAN_SCHED_PRIOR;
+    sched->score[11 - 1] = CHAN_SCHED_PRIOR;
+}
+
+void chan_sched_record(chan_sched_t *sched, uint8_t channel, uint16_t found)
+{
+    if (channel < 1 || channel > CHAN_SCHED_MAX_CHANNELS)
+    {
+        return;
+    }
+
+    uint32_t score = sched->score[channel - 1] + ((uint32_t)found << 4);
+    sched->score[channel - 1] = score > UINT16_MAX ? UINT16_MAX : score;
+}
+
+int chan_sched_plan(chan_sched_t *sched, uint8_t first_chan, uint8_t num_chans, uint8_t *plan)
+{
+    int len = 0;
+
+    for (int i = 0; i < CHAN_SCHED_MAX_CHANNELS; i++)
+    {
+        sched->score[i] -= sched->score[i] >> 2;
+    }
+
+    for (int chan = first_chan; chan < first_chan + num_chans && chan <= CHAN_SCHED_MAX_CHANNELS; chan++)
+    {
+        if (chan < 1)
+        {
+            continue;
+        }
+
+        // insertion sort, highest score first, lower channel first on ties
+        int pos = len++;
+        while (pos > 0 && sched->score[plan[pos - 1] - 1] < sched->score[chan - 1])
+        {
+            plan[pos] = plan[pos - 1];
+            pos -= 1;
+        }
+        plan[pos] = chan;
+    }
+    return len;
+}
@@ -0,0 +1,85 @@
+#include <string.h>
+#include "esp_attr.h"
+#include "frame_ring.h"
+
+#define FRAME_RING_MASK (FRAME_RING_SLOTS - 1)
+
+_Static_assert((FRAME_RING_SLOTS & FRAME_RING_MASK) == 0, "FRAME_RING_SLOTS must be a power of two");
+
+void frame_ring_init(frame_ring_t *ring)
+{
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->pushed, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->truncated, 0);
+    atomic_init(&ring->high_water, 0);
+}
+
+bool IRAM_ATTR frame_ring_push(frame_ring_t *ring, const uint8_t *frame, uint16_t frame_len,
+                               int8_t rssi, uint8_t channel, uint32_t rx_time)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    unsigned depth = head - tail;
+    if (depth >= FRAME_RING_SLOTS)
+    {
+        // full, the consumer is behind. Drop rather than block the driver.
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    frame_slot_t *slot = &ring->slots[head & FRAME_RING_MASK];
+    uint16_t copy_len = frame_len;
+    if (copy_len > FRAME_SLOT_SIZE)
+    {
+        copy_len = FRAME_SLOT_SIZE;
+        atomic_fetch_add_explicit(&ring->truncated, 1, memory_order_relaxed);
+    }
+    memcpy(slot->data, frame, copy_len);
+    slot->len = copy_len;
+    slot->frame_len = frame_len;
+    slot->rssi = rssi;
+    slot->channel = channel;
+    slot->rx_time = rx_time;
+
+    // publish the slot, the release pairs with the acquire in frame_ring_peek
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&ring->pushed, 1, memory_order_relaxed);
+
+    // only the producer writes high_water, so a plain load/store is enough
+    if (depth + 1 > atomic_load_explicit(&ring->high_water, memory_order_relaxed))
+    {
+        atomic_store_explicit(&ring->high_water, depth + 1, memory_order_relaxed);
+    }
+    return true;
+}
+
+const frame_slot_t *frame_ring_peek(frame_ring_t *ring)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return NULL;
+    }
+    return &ring->slots[tail & FRAME_RING_MASK];
+}
+
+void frame_ring_release(frame_ring_t *ring)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // hand the slot back, the release pairs with the acquire in frame_ring_push
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+void frame_ring_get_stats(frame_ring_t *ring, frame_ring_stats_t *stats)
+{
+    stats->pushed = atomic_load_explicit(&ring->pushed, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    stats->truncated = atomic_load_explicit(&ring->truncated, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+#include "ie_parser.h"
+
+bool ie_iter_next(ie_iter_t *it, ie_view_t *ie)
+{
+    // need the id and length bytes
+    if (it->end - it->pos < 2)
+    {
+        it->truncated = (it->pos != it->end);
+        return false;
+    }
+
+    uint8_t len = it->pos[1];
+    if (it->end - it->pos - 2 < len)
+    {
+        it->truncated = true;
+        return false;
+    }
+
+    ie->id = it->pos[0];
+    ie->len = len;
+    ie->data = it->pos + 2;
+    it->pos += 2 + len;
+    return true;
+}
+
+const uint8_t *mgmt_frame_ies(const uint8_t *frame, size_t frame_len, size_t *ies_len)
+{
+    if (frame_len < MGMT_HDR_LEN)
+    {
+        return NULL;
+    }
+
+    // beacons and probe responses carry fixed fields between the header and the elements
+    size_t offset = MGMT_HDR_LEN;
+    uint8_t subtype = frame[0] & 0xFC;
+    if (subtype == FRAME_SUBTYPE_PROBE_RESP || subtype == FRAME_SUBTYPE_BEACON)
+    {
+        offset += MGMT_FIXED_LEN;
+    }
+
+    if (frame_len < offset)
+    {
+        return NULL;
+    }
+    *ies_len = frame_len - offset;
+    return frame + offset;
+}
+
+void ie_parse(const uint8_t *ies, size_t ies_len, mgmt_ies_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    ie_iter_t it;
+    ie_view_t ie;
+    ie_iter_init(&it, ies, ies_len);
+    while (ie_iter_next(&it, &ie))
+    {
+        switch (ie.id)
+        {
+        case IE_SSID:
+            // only the first SSID element counts
+            if (!out->ssid.data)
+            {
+                out->ssid = ie;
+            }
+            break;
+        case IE_SUPPORTED_RATES:
+            out->rates = ie;
+            break;
+        case IE_EXT_RATES:
+            out->ext_rates = ie;
+            break;
+        case IE_DS_PARAMS:
+            if (ie.len >= 1)
+            {
+                out->ds_channel = ie.data[0];
+            }
+            break;
+        case IE_TIM:
+            // DTIM count, DTIM period, bitmap control, partial virtual bitmap
+            if (ie.len >= 3)
+            {
+                out->dtim_period = ie.data[1];
+            }
+            break;
+        case IE_RSN:
+            out->rsn = ie;
+            break;
+        case IE_HT_CAPS:
+            out->ht_caps = ie;
+            break;
+        default:
+            break;
+        }
+    }
+    out->truncated = it.truncated;
+}
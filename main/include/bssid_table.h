@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scan_result.h"
+
+// Open-addressed BSSID -> scan_result_t table with linear probing.
+// Keys are the 48-bit BSSID packed into a uint64 and live in one flat array, so a lookup
+// is a multiply, a shift and a short scan over adjacent words. Entries themselves stay in
+// the caller's storage (the result pool); the table only holds pointers to them. Storing them
+// inline would not survive removal: backward-shift deletion moves slots, while the eviction heap
+// and the delta report keep pointers to entries. A miss never touches an entry either way.
+// host/bssid_bench.c compares it with uthash.
+
+#ifndef BSSID_TABLE_SLOTS
+#define BSSID_TABLE_SLOTS 64 // power of two, at least 2x MAX_SCAN_RESULTS to keep probe runs short
+#endif
+#define BSSID_KEY_EMPTY UINT64_MAX
+
+_Static_assert(BSSID_TABLE_SLOTS >= 2 * MAX_SCAN_RESULTS, "BSSID table load factor must stay at or below 0.5");
+
+typedef struct bssid_table_t
+{
+    uint64_t keys[BSSID_TABLE_SLOTS];
+    scan_result_t *entries[BSSID_TABLE_SLOTS];
+    uint16_t count;
+} bssid_table_t;
+
+static inline uint64_t bssid_key(const uint8_t *bssid)
+{
+    return ((uint64_t)bssid[0] << 40) | ((uint64_t)bssid[1] << 32) | ((uint64_t)bssid[2] << 24) |
+           ((uint64_t)bssid[3] << 16) | ((uint64_t)bssid[4] << 8) | (uint64_t)bssid[5];
+}
+
+void bssid_table_init(bssid_table_t *table);
+void bssid_table_clear(bssid_table_t *table);
+
+// Returns NULL when the BSSID is not in the table
+scan_result_t *bssid_table_find(const bssid_table_t *table, uint64_t key);
+
+// Key must not already be present. Returns false when the table is full.
+bool bssid_table_insert(bssid_table_t *table, uint64_t key, scan_result_t *entry);
+
+// Returns the removed entry, or NULL when the BSSID is not in the table
+scan_result_t *bssid_table_remove(bssid_table_t *table, uint64_t key);
+
+// Iterate the table: start with *cursor = 0, returns NULL once every entry has been visited.
+// The table must not be modified during iteration.
+scan_result_t *bssid_table_next(const bssid_table_t *table, int *cursor);
+
+static inline uint16_t bssid_table_count(const bssid_table_t *table)
+{
+    return table->count;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Orders the channels of each scan cycle by a decayed score of past discoveries, so the channels
+// that historically turned up new BSSIDs are visited first. Scores are Q4 fixed point and decay
+// by a quarter every time a plan is built.
+
+#define CHAN_SCHED_MAX_CHANNELS 14 // 2.4 GHz
+
+typedef struct chan_sched_t
+{
+    uint16_t score[CHAN_SCHED_MAX_CHANNELS]; // index is channel - 1
+} chan_sched_t;
+
+// Seeds the non-overlapping channels 1/6/11 with a small prior so the first cycle starts there
+void chan_sched_init(chan_sched_t *sched);
+
+// Credit a channel with new BSSIDs found while dwelling on it
+void chan_sched_record(chan_sched_t *sched, uint8_t channel, uint16_t found);
+
+// Decay the scores and write the visit order for the next cycle into plan.
+// Only channels first_chan .. first_chan + num_chans - 1 (the configured country) are planned.
+// Returns the number of channels written.
+int chan_sched_plan(chan_sched_t *sched, uint8_t first_chan, uint8_t num_chans, uint8_t *plan);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Single-producer/single-consumer ring of fixed-size frame slots.
+// The promiscuous RX callback is the only producer, the scan RX task is the only consumer.
+// Neither side takes a lock; head is only written by the producer and tail only by the consumer.
+
+#define FRAME_RING_SLOTS 32 // must be a power of two
+#define FRAME_SLOT_SIZE 256 // bytes of 802.11 header + IEs kept per frame
+
+typedef struct frame_slot_t
+{
+    uint32_t rx_time;   // rx_ctrl.timestamp, microseconds
+    uint16_t frame_len; // length of the frame on air (rx_ctrl.sig_len)
+    uint16_t len;       // number of bytes copied into data
+    int8_t rssi;        // Signal strength (RSSI)
+    uint8_t channel;    // Wi-Fi channel the frame was received on
+    uint8_t data[FRAME_SLOT_SIZE];
+} frame_slot_t;
+
+typedef struct frame_ring_stats_t
+{
+    uint32_t pushed;     // frames handed to the consumer
+    uint32_t dropped;    // frames lost because the ring was full
+    uint32_t truncated;  // frames longer than FRAME_SLOT_SIZE, tail cut off
+    uint32_t high_water; // deepest the ring has been
+} frame_ring_stats_t;
+
+typedef struct frame_ring_t
+{
+    frame_slot_t slots[FRAME_RING_SLOTS];
+    atomic_uint head; // next slot the producer fills
+    atomic_uint tail; // next slot the consumer reads
+    atomic_uint pushed;
+    atomic_uint dropped;
+    atomic_uint truncated;
+    atomic_uint high_water;
+} frame_ring_t;
+
+void frame_ring_init(frame_ring_t *ring);
+
+// Producer side. Copies the frame into the next free slot and publishes it.
+// Returns false (and counts a drop) when the ring is full.
+bool frame_ring_push(frame_ring_t *ring, const uint8_t *frame, uint16_t frame_len,
+                     int8_t rssi, uint8_t channel, uint32_t rx_time);
+
+// Consumer side. Returns the oldest published slot, or NULL when empty.
+// The slot stays owned by the consumer until frame_ring_release().
+const frame_slot_t *frame_ring_peek(frame_ring_t *ring);
+void frame_ring_release(frame_ring_t *ring);
+
+void frame_ring_get_stats(frame_ring_t *ring, frame_ring_stats_t *stats);
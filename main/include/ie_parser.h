@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Zero-copy 802.11 information element parsing.
+// Elements are returned as (id, len, pointer) views into the caller's frame buffer and the
+// iterator never reads past the end it was given, so a bad length byte just ends the walk.
+
+#define MGMT_HDR_LEN 24     // Frame control .. sequence control
+#define MGMT_FIXED_LEN 12   // Timestamp, beacon interval and capability info in beacons/probe responses
+#define FRAME_FCS_LEN 4     // sig_len includes the trailing FCS
+
+#define FRAME_SUBTYPE_PROBE_REQ 0x40
+#define FRAME_SUBTYPE_PROBE_RESP 0x50
+#define FRAME_SUBTYPE_BEACON 0x80
+
+#define IE_SSID 0
+#define IE_SUPPORTED_RATES 1
+#define IE_DS_PARAMS 3
+#define IE_TIM 5
+#define IE_HT_CAPS 45
+#define IE_RSN 48
+#define IE_EXT_RATES 50
+
+#define IE_SSID_MAX_LEN 32
+
+typedef struct ie_view_t
+{
+    uint8_t id;
+    uint8_t len;
+    const uint8_t *data; // NULL when the element was not present
+} ie_view_t;
+
+typedef struct ie_iter_t
+{
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool truncated; // set once an element ran past the end of the buffer
+} ie_iter_t;
+
+// The elements the scanner cares about, pulled out of a frame in one pass
+typedef struct mgmt_ies_t
+{
+    ie_view_t ssid;
+    ie_view_t rates;
+    ie_view_t ext_rates;
+    ie_view_t rsn;
+    ie_view_t ht_caps;
+    uint8_t ds_channel; // channel the sender says it is on, 0 when there is no DS Parameter Set
+    uint8_t dtim_period; // from the TIM, 0 when there is none (only AP beacons carry one)
+    bool truncated;
+} mgmt_ies_t;
+
+static inline void ie_iter_init(ie_iter_t *it, const uint8_t *ies, size_t len)
+{
+    it->pos = ies;
+    it->end = ies + len;
+    it->truncated = false;
+}
+
+// Returns false at the end of the element list or when the next element is cut off
+bool ie_iter_next(ie_iter_t *it, ie_view_t *ie);
+
+// Locates the element list of a management frame.
+// frame_len is the number of valid bytes in frame (FCS already excluded).
+// Returns NULL when the frame is too short to carry any elements.
+const uint8_t *mgmt_frame_ies(const uint8_t *frame, size_t frame_len, size_t *ies_len);
+
+// Beacon interval of a beacon or probe response in TU (1024 us), 0 when the frame is too short.
+// frame_len is the number of valid bytes in frame.
+static inline uint16_t mgmt_beacon_interval(const uint8_t *frame, size_t frame_len)
+{
+    if (frame_len < MGMT_HDR_LEN + MGMT_FIXED_LEN)
+    {
+        return 0;
+    }
+    // after the 8 byte timestamp, little endian
+    return (uint16_t)(frame[MGMT_HDR_LEN + 8] | (frame[MGMT_HDR_LEN + 9] << 8));
+}
+
+// Walks the element list once and fills out. Elements that are absent have data == NULL.
+void ie_parse(const uint8_t *ies, size_t ies_len, mgmt_ies_t *out);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fixed-size latency histogram with logarithmic buckets, cheap enough to record on the hot path.
+// Values are microseconds. Below 2 us buckets are exact, above that every power of two is split
+// into two half-octave buckets, so a reported percentile is within ~20% of the true value.
+// Values of 2^20 us (~1 s) and more share the last bucket. No floating point anywhere.
+// Counts are halved when one would overflow, so a long running histogram favours recent samples.
+
+#define LATENCY_HIST_BUCKETS 41 // 2 exact + 2 per power of two up to 2^19, the last one starts at 2^20
+
+typedef struct latency_hist_t
+{
+    uint16_t counts[LATENCY_HIST_BUCKETS];
+    uint32_t total;
+    uint32_t max_us;
+} latency_hist_t;
+
+void latency_hist_init(latency_hist_t *hist);
+void latency_hist_record(latency_hist_t *hist, uint32_t us);
+
+// Upper bound of the bucket holding the pct-th percentile (1..100), the largest sample seen
+// for the overflow bucket, 0 when the histogram is empty
+uint32_t latency_hist_percentile(const latency_hist_t *hist, unsigned pct);
+
+static inline uint32_t latency_hist_count(const latency_hist_t *hist)
+{
+    return hist->total;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ie_parser.h"
+
+// Prebuilt probe request templates. Every (wildcard/directed SSID, rate set) combination is
+// assembled once at init with the STA's real MAC and trimmed to its real length, so sending a
+// probe is just handing the template to esp_wifi_80211_tx. The sequence number is left to the
+// driver (en_sys_seq), which is required once the STA is associated and keeps our probes in the
+// same sequence space as the driver's own frames.
+
+typedef enum
+{
+    PROBE_RATES_B,  // 1, 2, 5.5, 11 Mbps
+    PROBE_RATES_BG, // 802.11b rates plus the OFDM rates in Extended Supported Rates
+    PROBE_RATE_SETS
+} probe_rate_set_t;
+
+#define PROBE_FRAME_MAX (MGMT_HDR_LEN + 2 + IE_SSID_MAX_LEN + 2 + 8 + 2 + 8)
+
+typedef struct probe_template_t
+{
+    uint8_t frame[PROBE_FRAME_MAX];
+    uint16_t len;
+} probe_template_t;
+
+typedef struct probe_builder_t
+{
+    uint8_t mac[6];
+    probe_template_t templates[2][PROBE_RATE_SETS]; // [directed][rate set]
+} probe_builder_t;
+
+// Builds all templates for source address mac, directed ones ask for ssid (truncated to 32 bytes)
+void probe_builder_init(probe_builder_t *builder, const uint8_t mac[6], const char *ssid);
+
+// Returns the matching template, ready to transmit with the driver's sequence numbering
+const uint8_t *probe_builder_frame(const probe_builder_t *builder, bool directed, probe_rate_set_t rates, uint16_t *len);
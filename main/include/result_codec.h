@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "scan_result.h"
+
+// Binary encoding of scan results, for streaming over UART or storing at a fraction of the size of
+// the text reports. A batch is one report (delta or snapshot), all fields little-endian:
+//
+//   header   'S' 'R' version:u8 kind:u8 sweep:u16 count:u16 time_ms:u32      12 bytes
+//   record   len:u8, the number of record bytes that follow it
+//            op:u8 bssid:6 channel:u8 rssi:i8 flags:u8 last_sweep:u16
+//            ssid_len:u8 ssid:ssid_len
+//            rssi_avg:i8 rssi_min:i8 rssi_max:i8 samples:u16
+//            first_seen_ms:u32 last_seen_ms:u32                             27 + ssid_len bytes
+//   ...      count records
+//   trailer  crc:u16, CRC-16/CCITT-FALSE over header and records
+//
+// op is the same character as in the text report ('+', '-', '~', '='); removals carry only the
+// BSSID, every other field is zero. Fields are only ever appended to the record in a new version,
+// so a reader decodes the fields it knows from a newer batch and skips the rest of each record by
+// its len. A change that cannot be made by appending needs a new magic.
+//
+// Versions: 1 ends the record at the SSID, 2 appends the RSSI statistics (see rssi_stats.h),
+// 3 prefixes every record with its length. Versions 1 and 2 have no len byte, a reader has to
+// know their layout, which it does.
+// rssi is the latest sample, rssi_avg the smoothed one; times are esp_timer ms like time_ms.
+// Host side decoder: host/result_decoder.h, CLI: host/result_decode.c.
+
+#define RESULT_CODEC_MAGIC0 'S'
+#define RESULT_CODEC_MAGIC1 'R'
+#define RESULT_CODEC_VERSION 3
+
+#define RESULT_CODEC_HEADER_LEN 12
+#define RESULT_CODEC_LEN_PREFIX 1   // len byte in front of every record, since version 3
+#define RESULT_CODEC_RECORD_LEN 13 // from op up to and including ssid_len
+#define RESULT_CODEC_STATS_LEN 13  // after the SSID bytes, since version 2
+#define RESULT_CODEC_TRAILER_LEN 2
+#define RESULT_CODEC_MIN_RECORD (RESULT_CODEC_LEN_PREFIX + RESULT_CODEC_RECORD_LEN + RESULT_CODEC_STATS_LEN)
+#define RESULT_CODEC_MAX_RECORD (RESULT_CODEC_MIN_RECORD + 32)
+
+#define RESULT_CODEC_KIND_DELTA 0
+#define RESULT_CODEC_KIND_SNAPSHOT 1
+
+// Write a batch header, count can be patched in later with result_codec_set_count
+size_t result_codec_header(uint8_t *buf, uint8_t kind, uint16_t sweep, uint16_t count, uint32_t time_ms);
+void result_codec_set_count(uint8_t *buf, uint16_t count);
+
+// Append one record, entry is NULL for a removal. Returns bytes written, 0 when it does not fit in cap.
+size_t result_codec_record(uint8_t *buf, size_t cap, char op, const uint8_t *bssid, const scan_result_t *entry);
+
+// CRC over buf[0..len) and append it. Returns bytes written.
+size_t result_codec_trailer(uint8_t *buf, size_t len);
+
+uint16_t result_codec_crc16(const uint8_t *data, size_t len);
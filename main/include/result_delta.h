@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scan_result.h"
+#include "bssid_table.h"
+
+// Incremental reporting of the BSSID table. Each entry remembers what was last reported about it,
+// so a report only carries the BSSIDs that were added, removed or materially changed since the
+// previous one. One line per BSSID:
+//   +<bssid> <channel> <rssi> <flags> <ssid>   added
+//   ~<bssid> <channel> <rssi> <flags>          RSSI moved by DELTA_RSSI_THRESHOLD or more, or channel/flags changed
+//   -<bssid>                                   evicted or aged out of the table
+//   =<bssid> <channel> <rssi> <flags> <ssid>   full snapshot
+// BSSIDs are 12 hex digits, rssi is the smoothed RSSI (see rssi_stats.h), flags are SCAN_RESULT_FLAG_* in hex.
+// With RESULT_REPORT_BINARY set each report is instead written as one binary batch, see result_codec.h.
+
+#define DELTA_RSSI_THRESHOLD 6 // dB
+
+#ifndef RESULT_REPORT_BINARY
+#define RESULT_REPORT_BINARY 0
+#endif
+
+typedef struct result_delta_t
+{
+    uint8_t removed[MAX_SCAN_RESULTS][6]; // reported BSSIDs that left the table since the last report
+    uint16_t num_removed;
+    uint16_t removed_dropped; // removals that did not fit, the next snapshot resyncs the receiver
+    bool snapshot_due;        // the receiver can no longer follow with deltas, the next report must be a snapshot
+} result_delta_t;
+
+void result_delta_init(result_delta_t *delta);
+
+// The table was emptied without reporting the removals: forget the pending ones and make the next
+// report a snapshot
+void result_delta_reset(result_delta_t *delta);
+
+// entry is about to leave the table, call before it goes back to the pool
+void result_delta_removed(result_delta_t *delta, const scan_result_t *entry);
+
+// Report what changed since the last report or snapshot. Returns the number of lines printed.
+uint16_t result_delta_report(result_delta_t *delta, const bssid_table_t *table, uint16_t sweep);
+
+// Report every entry, for a receiver that is starting out or has lost track
+void result_delta_snapshot(result_delta_t *delta, const bssid_table_t *table, uint16_t sweep);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scan_result.h"
+
+// Binary min-heap over the entries in the scan results table, ordered so the root is the
+// entry to evict first: the stalest one (oldest sweep), and among equally fresh entries the
+// weakest smoothed RSSI (see rssi_stats.h). Each entry tracks its own position in heap_idx so updates are O(log n).
+
+typedef struct result_heap_t
+{
+    scan_result_t *items[MAX_SCAN_RESULTS];
+    uint16_t count;
+} result_heap_t;
+
+void result_heap_init(result_heap_t *heap);
+void result_heap_push(result_heap_t *heap, scan_result_t *entry);
+
+// Restore heap order after entry->stats or entry->sweep changed
+void result_heap_update(result_heap_t *heap, scan_result_t *entry);
+
+// Removes and returns the entry to evict, NULL when empty
+scan_result_t *result_heap_pop(result_heap_t *heap);
+
+// True when a would be evicted before b
+static inline bool result_evicts_before(const scan_result_t *a, const scan_result_t *b)
+{
+    if (a->sweep != b->sweep)
+    {
+        // sweep counter wraps, compare by distance
+        return (int16_t)(a->sweep - b->sweep) < 0;
+    }
+    return rssi_stats_avg(&a->stats) < rssi_stats_avg(&b->stats);
+}
+
+static inline scan_result_t *result_heap_peek(const result_heap_t *heap)
+{
+    return heap->count ? heap->items[0] : NULL;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include "scan_result.h"
+
+// Fixed-capacity pool of scan_result_t, sized at compile time from MAX_SCAN_RESULTS.
+// alloc/free are O(1) and never touch the heap; reset releases every entry at once
+// so the pool can be reused between scan cycles.
+
+typedef struct result_pool_t
+{
+    scan_result_t entries[MAX_SCAN_RESULTS];
+    uint16_t free_stack[MAX_SCAN_RESULTS]; // indices of entries handed back by result_pool_free
+    uint16_t free_top;                     // number of indices on free_stack
+    uint16_t next_fresh;                   // entries at or above this index have never been handed out
+    uint16_t in_use;
+    uint16_t high_water;
+} result_pool_t;
+
+void result_pool_init(result_pool_t *pool);
+
+// Returns NULL when every entry is in use
+scan_result_t *result_pool_alloc(result_pool_t *pool);
+void result_pool_free(result_pool_t *pool, scan_result_t *entry);
+
+// Release every entry in O(1), the high water mark is kept
+void result_pool_reset(result_pool_t *pool);
+
+static inline uint16_t result_pool_in_use(const result_pool_t *pool)
+{
+    return pool->in_use;
+}
+
+static inline uint16_t result_pool_high_water(const result_pool_t *pool)
+{
+    return pool->high_water;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scan_result.h"
+#include "bssid_table.h"
+#include "result_pool.h"
+#include "result_heap.h"
+#include "result_delta.h"
+
+// The scan results table: BSSID index, backing pool, eviction heap and delta bookkeeping in one
+// place, so every source of results (sniffed frames, driver scans) merges into the same table
+// the same way. Not thread safe, each table has a single writer task.
+
+typedef struct result_table_t
+{
+    bssid_table_t index;   // BSSID -> entry
+    result_pool_t pool;    // backing storage for the entries in index
+    result_heap_t heap;    // eviction order for the entries in index
+    result_delta_t delta;  // what changed since the last report
+    uint32_t evictions;
+    uint32_t resets;       // result_table_clear calls
+} result_table_t;
+
+void result_table_init(result_table_t *table);
+
+// Add or refresh a BSSID heard in sweep at now_ms (esp_timer time), folding rssi into its
+// statistics. When the table is full the stalest/weakest entry is evicted, unless every entry is
+// fresher or stronger than the newcomer.
+// Returns true when a BSSID we had not recorded yet was added.
+bool result_table_add(result_table_t *table, const uint8_t *bssid, const uint8_t *ssid, uint8_t ssid_len,
+                      uint8_t channel, int8_t rssi, uint8_t flags, uint16_t sweep, bool is_probe_resp,
+                      uint32_t now_ms);
+
+// Drop entries that have not been heard for stale_sweeps sweeps
+void result_table_age(result_table_t *table, uint16_t sweep, uint16_t stale_sweeps);
+
+// Drop every entry at once. Removals are not reported one by one, the next report is a snapshot.
+void result_table_clear(result_table_t *table);
+
+static inline uint16_t result_table_count(const result_table_t *table)
+{
+    return bssid_table_count(&table->index);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+// Running signal statistics for one BSSID, updated for every frame heard from it. Integer only and
+// O(1), cheap enough for the RX path.
+//
+// The average is an EWMA in Q4 fixed point (1/16 dB) with weight 1/RSSI_EWMA_WINDOW. Until that many
+// samples are in it is the plain mean, so a new BSSID is not pinned to its first reading.
+
+#define RSSI_EWMA_WINDOW 8 // samples, the EWMA weight is 1/RSSI_EWMA_WINDOW
+
+typedef struct rssi_stats_t
+{
+    int16_t avg_q4;         // smoothed RSSI, dBm << 4
+    int8_t min;             // weakest sample, dBm
+    int8_t max;             // strongest sample, dBm
+    uint16_t samples;       // frames counted, saturates
+    uint32_t first_seen_ms; // esp_timer time of the first sample
+    uint32_t last_seen_ms;  // esp_timer time of the latest sample
+} rssi_stats_t;
+
+static inline void rssi_stats_init(rssi_stats_t *stats, int8_t rssi, uint32_t now_ms)
+{
+    stats->avg_q4 = (int16_t)(rssi * 16);
+    stats->min = rssi;
+    stats->max = rssi;
+    stats->samples = 1;
+    stats->first_seen_ms = now_ms;
+    stats->last_seen_ms = now_ms;
+}
+
+static inline void rssi_stats_update(rssi_stats_t *stats, int8_t rssi, uint32_t now_ms)
+{
+    if (stats->samples < UINT16_MAX)
+    {
+        stats->samples += 1;
+    }
+    int weight = stats->samples < RSSI_EWMA_WINDOW ? stats->samples : RSSI_EWMA_WINDOW;
+    stats->avg_q4 += (int16_t)((rssi * 16 - stats->avg_q4) / weight);
+    if (rssi < stats->min)
+    {
+        stats->min = rssi;
+    }
+    if (rssi > stats->max)
+    {
+        stats->max = rssi;
+    }
+    stats->last_seen_ms = now_ms;
+}
+
+// Smoothed RSSI rounded to the nearest dBm
+static inline int8_t rssi_stats_avg(const rssi_stats_t *stats)
+{
+    int avg = stats->avg_q4;
+    return (int8_t)(avg >= 0 ? (avg + 8) / 16 : -((-avg + 8) / 16));
+}
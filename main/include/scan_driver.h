@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "result_table.h"
+
+// Driver scan backend of the scan engine: esp_wifi_scan_start without blocking, the driver posts
+// WIFI_EVENT_SCAN_DONE when it is over and the records are paged into the results table by the
+// table's writer task. Nothing here runs long on the esp_timer or event loop tasks, unless
+// BLOCKING_SCAN asks for the old behaviour.
+
+// 1: start a blocking scan from an esp_timer callback like interval-scan.c did, to compare the timer jitter
+// 0: start it without blocking from the scan task
+#ifndef BLOCKING_SCAN
+#define BLOCKING_SCAN 0
+#endif
+
+// worker is notified once a scan is done and scan_driver_collect has records to merge
+void scan_driver_init(TaskHandle_t worker);
+
+// Start a scan of every channel. When associated the driver goes back to the AP between channels.
+bool scan_driver_start(void);
+
+// True from SCAN_DONE until scan_driver_collect
+bool scan_driver_done(void);
+
+// Merge every record of the finished scan into table, returns the number of new BSSIDs. Also logs
+// the esp_timer task jitter seen during the scan and the time spent starting scans.
+uint16_t scan_driver_collect(result_table_t *table, uint16_t sweep);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// One scan engine, three ways to run a sweep. Every backend fills the same results table and goes
+// through the same sweep bookkeeping (reporting, discovery latency, connect, history), so their
+// SWEEP summaries can be compared directly on the same firmware:
+//   PROBE   hop the channel plan, listen and inject probe bursts (the default)
+//   SNIFF   hop the channel plan and only listen, never transmit. Beacons are taken as well and each
+//           channel gets a fixed dwell of one beacon interval, so the sweep time is predictable
+//   DRIVER  let the Wi-Fi driver scan (esp_wifi_scan_start), results are paged in on SCAN_DONE
+
+typedef enum scan_backend_t
+{
+    SCAN_BACKEND_PROBE,
+    SCAN_BACKEND_SNIFF,
+    SCAN_BACKEND_DRIVER,
+    SCAN_BACKEND_COUNT
+} scan_backend_t;
+
+// Backend at boot, can be changed with scan_engine_set_backend
+#ifndef SCAN_BACKEND
+#define SCAN_BACKEND SCAN_BACKEND_PROBE
+#endif
+
+// 1: every sweep uses the next backend in turn, for side by side comparisons
+#ifndef SCAN_BACKEND_ROTATE
+#define SCAN_BACKEND_ROTATE 0
+#endif
+
+// Takes effect from the next sweep, a sweep in progress finishes with the backend it started with
+void scan_engine_set_backend(scan_backend_t backend);
+scan_backend_t scan_engine_backend(void);
+const char *scan_backend_name(scan_backend_t backend);
+
+// Ask for a full snapshot at the end of the next sweep instead of a delta, e.g. after the uplink
+// reconnected. Safe to call from any task.
+void request_scan_snapshot(void);
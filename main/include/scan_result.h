@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rssi_stats.h"
+
+#ifndef MAX_SCAN_RESULTS
+#define MAX_SCAN_RESULTS 30 // how many results we store
+#endif
+
+#define SCAN_RESULT_FLAG_RSN 0x01 // advertised an RSN element (WPA2/WPA3)
+#define SCAN_RESULT_FLAG_HT 0x02  // advertised HT capabilities (802.11n)
+
+// Struct to hold scan results, from inject.c
+typedef struct scan_result_t
+{
+    uint8_t bssid[6];  // BSSID (MAC address)
+    uint8_t ssid[33];  // SSID
+    uint8_t channel;   // Wi-Fi channel
+    int8_t rssi;       // Signal strength (RSSI) of the latest frame
+    uint8_t flags;     // SCAN_RESULT_FLAG_*
+    uint16_t sweep;    // Scan cycle this BSSID was last heard in
+    uint16_t heap_idx; // Position in the eviction heap
+    bool recvResponse; // Flag to indicate that a probe response was heard for this particular ssid
+
+    // Signal over every frame heard from this BSSID, compare APs on this rather than the last rssi
+    rssi_stats_t stats;
+
+    // What the last delta report said about this BSSID, see result_delta.h
+    bool reported;           // included in a report since it was added
+    int8_t reported_rssi;
+    uint8_t reported_channel;
+    uint8_t reported_flags;
+} scan_result_t;
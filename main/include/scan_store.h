@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nvs.h"
+#include "chan_sched.h"
+
+// Sweep history kept in NVS so a reset starts warm: channel scores, the AP we connect to and the
+// BSSIDs recently heard. Records rotate through SCAN_STORE_SLOTS keys, the one with the highest
+// sequence number is the newest. NVS itself is log structured and wear levels its pages; rotating
+// keys also keeps the last few sweeps around should the newest record turn out to be unreadable.
+// Callers batch their writes, see STORE_EVERY_SWEEPS in scan.c.
+
+#define SCAN_STORE_NAMESPACE "opp_scan"
+#define SCAN_STORE_VERSION 1
+#define SCAN_STORE_SLOTS 4
+#define SCAN_STORE_BSSIDS 16 // freshest/strongest BSSIDs kept per record
+
+typedef struct scan_store_bssid_t
+{
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    uint16_t last_sweep;
+} scan_store_bssid_t;
+
+typedef struct scan_store_rec_t
+{
+    uint8_t version; // SCAN_STORE_VERSION, records of any other version are ignored
+    uint8_t num_bssids;
+    uint8_t target_channel; // 0 when there is no connect target
+    uint8_t target_bssid[6];
+    uint32_t seq; // write counter, the highest one is the newest record
+    uint16_t sweep;
+    uint16_t chan_score[CHAN_SCHED_MAX_CHANNELS]; // chan_sched_t scores, Q4
+    scan_store_bssid_t bssids[SCAN_STORE_BSSIDS];
+} scan_store_rec_t;
+
+typedef struct scan_store_t
+{
+    nvs_handle_t handle;
+    bool open;
+    uint32_t seq;      // of the newest record in flash
+    uint8_t next_slot; // where the next record goes
+    uint32_t writes;   // since boot
+} scan_store_t;
+
+// Open the NVS namespace and find the newest record. Returns false if NVS is unusable, in which
+// case the store stays closed and every other call is a no-op.
+bool scan_store_init(scan_store_t *store);
+
+// Newest valid record, false when there is none
+bool scan_store_load(scan_store_t *store, scan_store_rec_t *rec);
+
+// Write rec (seq and version are filled in) to the next slot and commit
+bool scan_store_save(scan_store_t *store, scan_store_rec_t *rec);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+
+// Scan trace: compact timestamped binary records instead of formatted log lines on the scan hot paths.
+// SCAN_TRACE_LEVEL picks what is compiled in, anything above it compiles to nothing:
+//   SCAN_TRACE_NONE    the default, no trace buffer at all
+//   SCAN_TRACE_EVENTS  channel hop state machine (timers, channel switches, probes)
+//   SCAN_TRACE_FRAMES  also every frame handled by the RX task
+// Records go into a fixed in-RAM ring (oldest overwritten) that is dumped at the end of each sweep,
+// host/trace_decode.c turns a dump into a per-channel timeline and latency histograms.
+// Not thread safe: only scan_rx_task traces, the RX callback and the timer callbacks do not.
+
+#define SCAN_TRACE_NONE 0
+#define SCAN_TRACE_EVENTS 1
+#define SCAN_TRACE_FRAMES 2
+
+#ifndef SCAN_TRACE_LEVEL
+#define SCAN_TRACE_LEVEL SCAN_TRACE_NONE // raise it from the build, e.g. host/CMakeLists.txt
+#endif
+
+#define SCAN_TRACE_DEPTH 512 // records, must be a power of two
+
+typedef enum
+{
+    // SCAN_TRACE_EVENTS
+    TRACE_PROBE_DELAY_EXPIRED = 1,
+    TRACE_PROBE_SENT,            // arg: 1 directed, 0 wildcard
+    TRACE_DWELL_AFTER_PROBE,
+    TRACE_DWELL_EXPIRED,
+    TRACE_CHAN_SWITCH,           // arg: channel switched to, emitted once the radio is on it
+    TRACE_SWEEP_START,
+    TRACE_CHAN_LEAVE,            // arg: channel about to switch to
+    TRACE_PROBE_ANSWERED,        // probe response addressed to us, arg: RSSI
+    TRACE_DWELL_EXTENDED,        // arg: ms from channel entry to the new deadline
+    TRACE_TARGET_SEEN,
+    TRACE_SWEEP_END,
+    TRACE_HOME_DWELL,            // back on the associated AP's channel between windows, arg: ms
+    // SCAN_TRACE_FRAMES
+    TRACE_PROBE_REQ_RX,          // arg: RSSI
+    TRACE_PROBE_RESP_RX,         // arg: RSSI
+    TRACE_PROBE_TIMER_STOPPED,   // a frame cut the probe delay short
+    TRACE_DWELL_AFTER_RX,
+    TRACE_PROBE_DELAY_INACTIVE,  // frame arrived after the probe delay was over
+    TRACE_RESULT_ADDED,          // arg: distinct BSSIDs in the table
+    TRACE_BEACON_RX,             // arg: RSSI, only ingested by passive (sniff) sweeps
+    TRACE_EVENT_COUNT
+} scan_trace_event_t;
+
+typedef struct scan_trace_rec_t
+{
+    uint32_t time_us; // low 32 bits of esp_timer_get_time(), wraps after ~71 minutes
+    uint8_t event;    // scan_trace_event_t
+    uint8_t channel;  // channel the radio was on
+    uint16_t arg;     // event specific
+} scan_trace_rec_t;
+
+// Name of a trace event, also used by the host decoder to parse dumps. NULL for unknown ids.
+const char *scan_trace_event_name(uint8_t event);
+
+#if SCAN_TRACE_LEVEL > SCAN_TRACE_NONE
+void scan_trace_emit(uint8_t event, uint8_t channel, uint16_t arg);
+void scan_trace_dump(void);
+#define SCAN_TRACE_DUMP() scan_trace_dump()
+#else
+#define SCAN_TRACE_DUMP() ((void)0)
+#endif
+
+// A compiled out trace call still names its arguments, without evaluating them, so variables that
+// only feed the trace do not become unused
+#define SCAN_TRACE_NOP(channel, arg) ((void)sizeof(channel), (void)sizeof(arg))
+
+#if SCAN_TRACE_LEVEL >= SCAN_TRACE_EVENTS
+#define SCAN_TRACE_EVENT(event, channel, arg) scan_trace_emit((event), (channel), (arg))
+#else
+#define SCAN_TRACE_EVENT(event, channel, arg) SCAN_TRACE_NOP(channel, arg)
+#endif
+
+#if SCAN_TRACE_LEVEL >= SCAN_TRACE_FRAMES
+#define SCAN_TRACE_FRAME(event, channel, arg) scan_trace_emit((event), (channel), (arg))
+#else
+#define SCAN_TRACE_FRAME(event, channel, arg) SCAN_TRACE_NOP(channel, arg)
+#endif
@@ -0,0 +1,80 @@
+#include <string.h>
+#include "latency_hist.h"
+
+void latency_hist_init(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+static inline unsigned bucket_of(uint32_t us)
+{
+    if (us < 2)
+    {
+        return us;
+    }
+    unsigned msb = 31 - __builtin_clz(us);
+    unsigned idx = msb * 2 + ((us >> (msb - 1)) & 1);
+    return idx < LATENCY_HIST_BUCKETS ? idx : LATENCY_HIST_BUCKETS - 1;
+}
+
+// Smallest value that lands in bucket idx
+static uint32_t bucket_floor(unsigned idx)
+{
+    if (idx < 2)
+    {
+        return idx;
+    }
+    return (uint32_t)(2 | (idx & 1)) << (idx / 2 - 1);
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t us)
+{
+    unsigned idx = bucket_of(us);
+
+    if (hist->counts[idx] == UINT16_MAX)
+    {
+        hist->total = 0;
+        for (unsigned i = 0; i < LATENCY_HIST_BUCKETS; i++)
+        {
+            hist->counts[i] /= 2;
+            hist->total += hist->counts[i];
+        }
+    }
+    hist->counts[idx] += 1;
+    hist->total += 1;
+    if (us > hist->max_us)
+    {
+        hist->max_us = us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, unsigned pct)
+{
+    if (hist->total == 0)
+    {
+        return 0;
+    }
+    if (pct > 100)
+    {
+        pct = 100;
+    }
+
+    // rank of the sample we want, rounded up so p99 of a few samples is the largest one
+    uint32_t rank = (uint32_t)(((uint64_t)hist->total * pct + 99) / 100);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    uint32_t seen = 0;
+    for (unsigned i = 0; i < LATENCY_HIST_BUCKETS - 1; i++)
+    {
+        seen += hist->counts[i];
+        if (seen >= rank)
+        {
+            uint32_t upper = bucket_floor(i + 1) - 1;
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
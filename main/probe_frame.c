@@ -0,0 +1,71 @@
+#include <string.h>
+#include "probe_frame.h"
+
+static const uint8_t rates_b[] = {0x82, 0x84, 0x8B, 0x96};                         // 1, 2, 5.5, 11 Mbps (basic)
+static const uint8_t rates_bg[] = {0x82, 0x84, 0x8B, 0x96, 0x12, 0x24, 0x48, 0x6C}; // + 9, 18, 36, 54 Mbps
+static const uint8_t ext_rates_bg[] = {0x0C, 0x18, 0x30, 0x60};                     // 6, 12, 24, 48 Mbps
+
+static uint8_t *put_ie(uint8_t *pos, uint8_t id, const uint8_t *data, uint8_t len)
+{
+    pos[0] = id;
+    pos[1] = len;
+    if (len)
+    {
+        memcpy(pos + 2, data, len);
+    }
+    return pos + 2 + len;
+}
+
+static void build_template(probe_template_t *tmpl, const uint8_t mac[6], const uint8_t *ssid, uint8_t ssid_len,
+                           probe_rate_set_t rates)
+{
+    uint8_t *pos = tmpl->frame;
+
+    *pos++ = 0x40; // Frame Control (0x40 = probe request)
+    *pos++ = 0x00;
+    *pos++ = 0x00; // Duration
+    *pos++ = 0x00;
+    memset(pos, 0xFF, 6); // Destination MAC (broadcast)
+    pos += 6;
+    memcpy(pos, mac, 6); // Source MAC (our STA MAC)
+    pos += 6;
+    memset(pos, 0xFF, 6); // BSSID (broadcast)
+    pos += 6;
+    *pos++ = 0x00; // Sequence Control, filled in by the driver
+    *pos++ = 0x00;
+
+    pos = put_ie(pos, IE_SSID, ssid, ssid_len); // zero length for the wildcard SSID
+    if (rates == PROBE_RATES_B)
+    {
+        pos = put_ie(pos, IE_SUPPORTED_RATES, rates_b, sizeof(rates_b));
+    }
+    else
+    {
+        pos = put_ie(pos, IE_SUPPORTED_RATES, rates_bg, sizeof(rates_bg));
+        pos = put_ie(pos, IE_EXT_RATES, ext_rates_bg, sizeof(ext_rates_bg));
+    }
+    tmpl->len = pos - tmpl->frame;
+}
+
+void probe_builder_init(probe_builder_t *builder, const uint8_t mac[6], const char *ssid)
+{
+    size_t ssid_len = strlen(ssid);
+    if (ssid_len > IE_SSID_MAX_LEN)
+    {
+        ssid_len = IE_SSID_MAX_LEN;
+    }
+
+    memcpy(builder->mac, mac, 6);
+    for (int rates = 0; rates < PROBE_RATE_SETS; rates++)
+    {
+        build_template(&builder->templates[0][rates], mac, NULL, 0, rates);
+        build_template(&builder->templates[1][rates], mac, (const uint8_t *)ssid, ssid_len, rates);
+    }
+}
+
+const uint8_t *probe_builder_frame(const probe_builder_t *builder, bool directed, probe_rate_set_t rates, uint16_t *len)
+{
+    const probe_template_t *tmpl = &builder->templates[directed ? 1 : 0][rates];
+    *len = tmpl->len;
+    return tmpl->frame;
+}
@@ -0,0 +1,85 @@
+#include <string.h>
+#include "result_codec.h"
+
+static inline void put16le(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32le(uint8_t *p, uint32_t v)
+{
+    put16le(p, (uint16_t)v);
+    put16le(p + 2, (uint16_t)(v >> 16));
+}
+
+size_t result_codec_header(uint8_t *buf, uint8_t kind, uint16_t sweep, uint16_t count, uint32_t time_ms)
+{
+    buf[0] = RESULT_CODEC_MAGIC0;
+    buf[1] = RESULT_CODEC_MAGIC1;
+    buf[2] = RESULT_CODEC_VERSION;
+    buf[3] = kind;
+    put16le(buf + 4, sweep);
+    put16le(buf + 6, count);
+    put32le(buf + 8, time_ms);
+    return RESULT_CODEC_HEADER_LEN;
+}
+
+void result_codec_set_count(uint8_t *buf, uint16_t count)
+{
+    put16le(buf + 6, count);
+}
+
+size_t result_codec_record(uint8_t *buf, size_t cap, char op, const uint8_t *bssid, const scan_result_t *entry)
+{
+    size_t ssid_len = entry ? strnlen((const char *)entry->ssid, 32) : 0;
+    size_t len = RESULT_CODEC_MIN_RECORD + ssid_len;
+    if (cap < len)
+    {
+        return 0;
+    }
+
+    memset(buf, 0, len);
+    buf[0] = (uint8_t)(len - RESULT_CODEC_LEN_PREFIX);
+    buf += RESULT_CODEC_LEN_PREFIX;
+    buf[0] = (uint8_t)op;
+    memcpy(buf + 1, bssid, 6);
+    if (entry)
+    {
+        buf[7] = entry->channel;
+        buf[8] = (uint8_t)entry->rssi;
+        buf[9] = entry->flags;
+        put16le(buf + 10, entry->sweep);
+        buf[12] = (uint8_t)ssid_len;
+        memcpy(buf + RESULT_CODEC_RECORD_LEN, entry->ssid, ssid_len);
+
+        uint8_t *stats = buf + RESULT_CODEC_RECORD_LEN + ssid_len;
+        stats[0] = (uint8_t)rssi_stats_avg(&entry->stats);
+        stats[1] = (uint8_t)entry->stats.min;
+        stats[2] = (uint8_t)entry->stats.max;
+        put16le(stats + 3, entry->stats.samples);
+        put32le(stats + 5, entry->stats.first_seen_ms);
+        put32le(stats + 9, entry->stats.last_seen_ms);
+    }
+    return len;
+}
+
+size_t result_codec_trailer(uint8_t *buf, size_t len)
+{
+    put16le(buf + len, result_codec_crc16(buf, len));
+    return RESULT_CODEC_TRAILER_LEN;
+}
+
+uint16_t result_codec_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
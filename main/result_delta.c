@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <string.h>
+#include "result_delta.h"
+
+#if RESULT_REPORT_BINARY
+#include "esp_timer.h"
+#include "result_codec.h"
+
+// Worst case batch: every entry removed and a full table added back
+#define BATCH_MAX_LEN (RESULT_CODEC_HEADER_LEN + MAX_SCAN_RESULTS * RESULT_CODEC_MIN_RECORD + \
+                       MAX_SCAN_RESULTS * RESULT_CODEC_MAX_RECORD + RESULT_CODEC_TRAILER_LEN)
+
+static uint8_t batch_buf[BATCH_MAX_LEN];
+static size_t batch_len;
+static uint16_t batch_count;
+
+static void batch_begin(uint8_t kind, uint16_t sweep)
+{
+    batch_len = result_codec_header(batch_buf, kind, sweep, 0, (uint32_t)(esp_timer_get_time() / 1000));
+    batch_count = 0;
+}
+
+static void batch_add(char op, const uint8_t *bssid, const scan_result_t *entry)
+{
+    size_t n = result_codec_record(batch_buf + batch_len, sizeof(batch_buf) - RESULT_CODEC_TRAILER_LEN - batch_len,
+                                   op, bssid, entry);
+    if (n)
+    {
+        batch_len += n;
+        batch_count += 1;
+    }
+}
+
+// Raw bytes on stdout, the decoder finds batches between log lines by their magic and CRC
+static void batch_end()
+{
+    result_codec_set_count(batch_buf, batch_count);
+    batch_len += result_codec_trailer(batch_buf, batch_len);
+    fwrite(batch_buf, 1, batch_len, stdout);
+    fflush(stdout);
+}
+#else
+#define BSSID_HEX_FMT "%02x%02x%02x%02x%02x%02x"
+#define BSSID_HEX(b) (b)[0], (b)[1], (b)[2], (b)[3], (b)[4], (b)[5]
+#endif
+
+void result_delta_init(result_delta_t *delta)
+{
+    delta->num_removed = 0;
+    delta->removed_dropped = 0;
+    delta->snapshot_due = false;
+}
+
+void result_delta_reset(result_delta_t *delta)
+{
+    delta->num_removed = 0;
+    delta->removed_dropped = 0;
+    delta->snapshot_due = true;
+}
+
+void result_delta_removed(result_delta_t *delta, const scan_result_t *entry)
+{
+    if (!entry->reported)
+    {
+        return; // the receiver never heard of it
+    }
+    if (delta->num_removed >= MAX_SCAN_RESULTS)
+    {
+        delta->removed_dropped += 1;
+        return;
+    }
+    memcpy(delta->removed[delta->num_removed++], entry->bssid, 6);
+}
+
+static bool changed_materially(const scan_result_t *entry)
+{
+    int rssi_delta = rssi_stats_avg(&entry->stats) - entry->reported_rssi;
+    if (rssi_delta < 0)
+    {
+        rssi_delta = -rssi_delta;
+    }
+    return rssi_delta >= DELTA_RSSI_THRESHOLD || entry->channel != entry->reported_channel ||
+           entry->flags != entry->reported_flags;
+}
+
+static void mark_reported(scan_result_t *entry)
+{
+    entry->reported = true;
+    entry->reported_rssi = rssi_stats_avg(&entry->stats);
+    entry->reported_channel = entry->channel;
+    entry->reported_flags = entry->flags;
+}
+
+static void emit_entry(char kind, const scan_result_t *entry)
+{
+#if RESULT_REPORT_BINARY
+    batch_add(kind, entry->bssid, entry);
+#else
+    printf("%c" BSSID_HEX_FMT " %u %d %x", kind, BSSID_HEX(entry->bssid), entry->channel,
+           rssi_stats_avg(&entry->stats), entry->flags);
+    if (kind != '~')
+    {
+        printf(" %s", entry->ssid);
+    }
+    putchar('\n');
+#endif
+}
+
+static void emit_removed(const uint8_t *bssid)
+{
+#if RESULT_REPORT_BINARY
+    batch_add('-', bssid, NULL);
+#else
+    printf("-" BSSID_HEX_FMT "\n", BSSID_HEX(bssid));
+#endif
+}
+
+uint16_t result_delta_report(result_delta_t *delta, const bssid_table_t *table, uint16_t sweep)
+{
+    uint16_t added = 0;
+    uint16_t changed = 0;
+    scan_result_t *entry;
+    int cursor = 0;
+
+#if RESULT_REPORT_BINARY
+    batch_begin(RESULT_CODEC_KIND_DELTA, sweep);
+#endif
+    for (uint16_t i = 0; i < delta->num_removed; i++)
+    {
+        emit_removed(delta->removed[i]);
+    }
+
+    while ((entry = bssid_table_next(table, &cursor)) != NULL)
+    {
+        if (!entry->reported)
+        {
+            emit_entry('+', entry);
+            added += 1;
+        }
+        else if (changed_materially(entry))
+        {
+            emit_entry('~', entry);
+            changed += 1;
+        }
+        else
+        {
+            continue;
+        }
+        mark_reported(entry);
+    }
+
+#if RESULT_REPORT_BINARY
+    batch_end();
+#else
+    printf("DELTA %u: +%u -%u ~%u, %u in table%s\n", sweep, added, delta->num_removed, changed,
+           bssid_table_count(table), delta->removed_dropped ? ", removals lost, snapshot needed" : "");
+#endif
+
+    uint16_t lines = added + changed + delta->num_removed;
+    delta->num_removed = 0;
+    return lines;
+}
+
+void result_delta_snapshot(result_delta_t *delta, const bssid_table_t *table, uint16_t sweep)
+{
+    scan_result_t *entry;
+    int cursor = 0;
+
+#if RESULT_REPORT_BINARY
+    batch_begin(RESULT_CODEC_KIND_SNAPSHOT, sweep);
+#endif
+    while ((entry = bssid_table_next(table, &cursor)) != NULL)
+    {
+        emit_entry('=', entry);
+        mark_reported(entry);
+    }
+#if RESULT_REPORT_BINARY
+    batch_end();
+#else
+    printf("SNAPSHOT %u: %u in table\n", sweep, bssid_table_count(table));
+#endif
+
+    delta->num_removed = 0;
+    delta->removed_dropped = 0;
+    delta->snapshot_due = false;
+}
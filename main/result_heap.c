@@ -0,0 +1,84 @@
+#include <stddef.h>
+#include "result_heap.h"
+
+static inline void heap_place(result_heap_t *heap, uint16_t idx, scan_result_t *entry)
+{
+    heap->items[idx] = entry;
+    entry->heap_idx = idx;
+}
+
+static void sift_up(result_heap_t *heap, uint16_t idx)
+{
+    scan_result_t *entry = heap->items[idx];
+    while (idx > 0)
+    {
+        uint16_t parent = (idx - 1) / 2;
+        if (!result_evicts_before(entry, heap->items[parent]))
+        {
+            break;
+        }
+        heap_place(heap, idx, heap->items[parent]);
+        idx = parent;
+    }
+    heap_place(heap, idx, entry);
+}
+
+static void sift_down(result_heap_t *heap, uint16_t idx)
+{
+    scan_result_t *entry = heap->items[idx];
+    while (1)
+    {
+        uint16_t child = 2 * idx + 1;
+        if (child >= heap->count)
+        {
+            break;
+        }
+        if (child + 1 < heap->count && result_evicts_before(heap->items[child + 1], heap->items[child]))
+        {
+            child += 1;
+        }
+        if (!result_evicts_before(heap->items[child], entry))
+        {
+            break;
+        }
+        heap_place(heap, idx, heap->items[child]);
+        idx = child;
+    }
+    heap_place(heap, idx, entry);
+}
+
+void result_heap_init(result_heap_t *heap)
+{
+    heap->count = 0;
+}
+
+void result_heap_push(result_heap_t *heap, scan_result_t *entry)
+{
+    uint16_t idx = heap->count++;
+    heap_place(heap, idx, entry);
+    sift_up(heap, idx);
+}
+
+void result_heap_update(result_heap_t *heap, scan_result_t *entry)
+{
+    // the key can move either way (RSSI drops, sweep moves forward), try both directions
+    sift_up(heap, entry->heap_idx);
+    sift_down(heap, entry->heap_idx);
+}
+
+scan_result_t *result_heap_pop(result_heap_t *heap)
+{
+    if (heap->count == 0)
+    {
+        return NULL;
+    }
+
+    scan_result_t *root = heap->items[0];
+    heap->count -= 1;
+    if (heap->count > 0)
+    {
+        heap_place(heap, 0, heap->items[heap->count]);
+        sift_down(heap, 0);
+    }
+    return root;
+}
@@ -0,0 +1,52 @@
+#include <string.h>
+#include "result_pool.h"
+
+void result_pool_init(result_pool_t *pool)
+{
+    pool->free_top = 0;
+    pool->next_fresh = 0;
+    pool->in_use = 0;
+    pool->high_water = 0;
+}
+
+scan_result_t *result_pool_alloc(result_pool_t *pool)
+{
+    uint16_t idx;
+
+    if (pool->free_top > 0)
+    {
+        // reuse an entry that was handed back
+        idx = pool->free_stack[--pool->free_top];
+    }
+    else if (pool->next_fresh < MAX_SCAN_RESULTS)
+    {
+        idx = pool->next_fresh++;
+    }
+    else
+    {
+        return NULL;
+    }
+
+    pool->in_use += 1;
+    if (pool->in_use > pool->high_water)
+    {
+        pool->high_water = pool->in_use;
+    }
+
+    scan_result_t *entry = &pool->entries[idx];
+    memset(entry, 0, sizeof(*entry));
+    return entry;
+}
+
+void result_pool_free(result_pool_t *pool, scan_result_t *entry)
+{
+    pool->free_stack[pool->free_top++] = (uint16_t)(entry - pool->entries);
+    pool->in_use -= 1;
+}
+
+void result_pool_reset(result_pool_t *pool)
+{
+    pool->free_top = 0;
+    pool->next_fresh = 0;
+    pool->in_use = 0;
+}
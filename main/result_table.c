@@ -0,0 +1,113 @@
+#include <string.h>
+#include "result_table.h"
+
+void result_table_init(result_table_t *table)
+{
+    result_pool_init(&table->pool);
+    bssid_table_init(&table->index);
+    result_heap_init(&table->heap);
+    result_delta_init(&table->delta);
+    table->evictions = 0;
+    table->resets = 0;
+}
+
+// entry is already off the heap, take it out of the index and hand it back to the pool
+static void drop_entry(result_table_t *table, scan_result_t *entry)
+{
+    bssid_table_remove(&table->index, bssid_key(entry->bssid));
+    result_delta_removed(&table->delta, entry);
+    result_pool_free(&table->pool, entry);
+}
+
+// Evict the stalest/weakest entry to make room for a new BSSID heard at rssi.
+// Returns false when every entry is fresher or stronger than the newcomer, in which case the table is kept.
+static bool evict_entry(result_table_t *table, int8_t rssi, uint16_t sweep)
+{
+    scan_result_t *weakest = result_heap_peek(&table->heap);
+    if (!weakest || (weakest->sweep == sweep && rssi_stats_avg(&weakest->stats) >= rssi))
+    {
+        return false;
+    }
+
+    result_heap_pop(&table->heap);
+    drop_entry(table, weakest);
+    table->evictions += 1;
+    return true;
+}
+
+bool result_table_add(result_table_t *table, const uint8_t *bssid, const uint8_t *ssid, uint8_t ssid_len,
+                      uint8_t channel, int8_t rssi, uint8_t flags, uint16_t sweep, bool is_probe_resp,
+                      uint32_t now_ms)
+{
+    // Check if the BSSID is already in the table
+    uint64_t key = bssid_key(bssid);
+    scan_result_t *result = bssid_table_find(&table->index, key);
+
+    if (result)
+    {
+        // Update the existing entry
+        result->channel = channel;
+        result->rssi = rssi;
+        rssi_stats_update(&result->stats, rssi, now_ms);
+        result->flags = flags;
+        result->sweep = sweep;
+        if (is_probe_resp)
+        {
+            result->recvResponse = true;
+        }
+        result_heap_update(&table->heap, result);
+        return false;
+    }
+
+    // Table is full, make room by dropping the weakest or stalest entry
+    if (bssid_table_count(&table->index) >= MAX_SCAN_RESULTS && !evict_entry(table, rssi, sweep))
+    {
+        return false;
+    }
+
+    // Create a new entry, we have not seen this BSSID before
+    result = result_pool_alloc(&table->pool);
+    if (!result)
+    {
+        return false;
+    }
+    if (ssid_len > sizeof(result->ssid) - 1)
+    {
+        ssid_len = sizeof(result->ssid) - 1;
+    }
+    memcpy(result->bssid, bssid, 6);
+    memcpy(result->ssid, ssid, ssid_len);
+    result->ssid[ssid_len] = '\0'; // Ensure SSID is null-terminated
+    result->channel = channel;
+    result->rssi = rssi;
+    rssi_stats_init(&result->stats, rssi, now_ms);
+    result->flags = flags;
+    result->sweep = sweep;
+    result->recvResponse = is_probe_resp;
+    result->reported = false; // goes out as added in the next report
+    // Add to the table and the eviction order
+    bssid_table_insert(&table->index, key, result);
+    result_heap_push(&table->heap, result);
+    return true;
+}
+
+// The heap root is always the stalest entry, so this only looks at as many entries as it removes
+void result_table_age(result_table_t *table, uint16_t sweep, uint16_t stale_sweeps)
+{
+    scan_result_t *oldest;
+    while ((oldest = result_heap_peek(&table->heap)) != NULL &&
+           (int16_t)(sweep - oldest->sweep) >= stale_sweeps)
+    {
+        result_heap_pop(&table->heap);
+        drop_entry(table, oldest);
+    }
+}
+
+void result_table_clear(result_table_t *table)
+{
+    bssid_table_clear(&table->index);
+    result_heap_init(&table->heap);
+    result_pool_reset(&table->pool);
+    result_delta_reset(&table->delta);
+    table->resets += 1;
+}
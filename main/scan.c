@@ -1,4 +1,5 @@
 #include <string.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
@@ -9,121 +10,219 @@
 #include "esp_netif.h"
 #include "nvs_flash.h"
 #include "esp_timer.h"
-#include "uthash.h"
+#include "frame_ring.h"
+#include "scan_result.h"
+#include "result_pool.h"
+#include "bssid_table.h"
+#include "result_table.h"
+#include "ie_parser.h"
+#include "chan_sched.h"
+#include "probe_frame.h"
+#include "scan_trace.h"
+#include "latency_hist.h"
+#include "result_delta.h"
+#include "scan_store.h"
+#include "scan_engine.h"
+#include "scan_driver.h"
 
 #define WIFI_SSID "ssid"
 #define WIFI_PASS "pass"
 
+// 1: send directed probes for WIFI_SSID and end the sweep at its first probe response
+// 0: wildcard probes and a full sweep of every planned channel
+#define TARGETED_SCAN 1
+
+// 1: connect straight to the strongest BSSID/channel for WIFI_SSID found by the sweep
+// 0: SSID-only connect, the driver rescans first (kept to compare connect latency)
+#define CONNECT_WITH_SCAN_HINT 1
+
+// 1: after a background sweep, reconnect to another BSSID for WIFI_SSID that is clearly stronger
+// 0: stay on the AP we joined until the driver drops it
+#define ROAM_TO_STRONGER_AP 1
+#define ROAM_MARGIN 8       // dB, smoothed RSSI a candidate needs over the associated AP to roam to it
+#define ROAM_MIN_SAMPLES 4  // frames heard from a candidate before its smoothed RSSI is trusted
+
+#define PROBE_RATE_SET PROBE_RATES_BG // rates advertised in our probe requests, see probe_frame.h
+
 // times are in ms
 #define PROBE_DELAY 20      // how much delay before each burst of probes
 #define PROBE_INTERVAL 30   // time between each 802.11 probe request frame within a burst
 #define NUM_PROBES 3        // number of probe requests in each burst
 #define CHAN_DWELL_TIME 100 // how long we stay on channel for each "probe event"
+#define CHAN_MIN_DWELL_TIME 20  // dwell on a channel that has never produced a new BSSID
+#define CHAN_MAX_DWELL_TIME 300 // upper bound on time spent on one channel, however busy
+#define CHAN_QUIET_TIME 40      // leave a channel once no new BSSID has shown up for this long
+#define MAX_DISCOVERIES 128     // discovery timestamps kept per sweep for the latency report
 // #define LISTEN_TIME 10 //how long we listen on the channel for responses
 #define SCAN_INTERVAL 60000 // how long each we wait between scan events
-#define MAX_SCAN_RESULTS 30 // how many results we store
+#define BG_OFF_CHAN_TIME 120    // while associated, longest we stay away from the AP's channel in one go
+#define BG_HOME_DWELL_TIME 250  // while associated, time back on the AP's channel between off-channel windows
 #define NUM_CHANNELS 14     // 14 chan on 2.4 ghz
+#define RESULT_STALE_SWEEPS 3   // drop BSSIDs that have not been heard for this many sweeps
+#define FULL_SNAPSHOT_EVERY 10  // sweeps between full snapshots, the ones in between only report deltas
+#ifndef RESULT_RESET_EVERY
+#define RESULT_RESET_EVERY 60   // sweeps between bulk resets of the results table, 0 to only age entries out
+#endif
+#define STORE_EVERY_SWEEPS 5    // sweeps between writes of the sweep history to flash, unless the connect target moved
+#define WARM_SWEEP_DELAY 5000   // after connecting straight from the stored history, first sweep this long after boot
+#define DEFAULT_BEACON_INT 100  // TU, what almost every AP uses, assumed until a channel's beacons say otherwise
+#define PASSIVE_DWELL_MARGIN 8  // ms on top of one beacon interval per channel in passive sweeps
+
+#define SCAN_RX_TASK_STACK 4096 // bytes
+#define SCAN_RX_TASK_PRIO 10    // below the Wi-Fi driver task, above the main task
 
 static void probe_timer_cb();
 static void chanDwell_timer_cb();
+static void burst_timer_cb();
+static void sweep_timer_cb();
+static void probe_delay_expired();
+static void chan_dwell_expired();
+static void burst_tick();
 
 static void switch_to_next_channel();
+static void start_chan_visit();
+static void start_home_dwell();
+static void tune_to_next_channel(uint8_t from_chan);
+static void start_probe_burst();
+static void stop_probe_burst();
+static void print_chan_stats();
+static void build_chan_plan();
+static void start_chan_dwell(uint32_t default_ms);
+static void note_chan_discovery();
 static void init_timers();
 static void send_probe_request();
+static void start_sweep();
 static void finished_dynamo_probe();
+static void report_scan_results();
+static void save_scan_history();
+static const char *connect_target(uint8_t *bssid, uint8_t *channel);
 static void IRAM_ATTR listen_handler(void *buff, wifi_promiscuous_pkt_type_t type);
-static inline void IRAM_ATTR print_scan_results();
+static void scan_rx_task(void *arg);
+static void scan_rx_drain();
+static void process_frame(const frame_slot_t *slot);
 
 // Timer handlers
 static esp_timer_handle_t probe_timer_handler;
 static esp_timer_handle_t chanDwell_timer_handler;
+static esp_timer_handle_t burst_timer_handler;
+static esp_timer_handle_t sweep_timer_handler;
 
 //***********************************************************************
 //*                                                                     *
 //************************************************************************
 
-// Struct to hold scan results, from inject.c
-typedef struct scan_result_t
-{
-    uint8_t bssid[6];  // BSSID (MAC address)
-    uint8_t ssid[33];  // SSID
-    uint8_t channel;   // Wi-Fi channel
-    int8_t rssi;       // Signal strength (RSSI)
-    UT_hash_handle hh; // Hash table handle
-    bool recvResponse; // Flag to indicate that a probe response was heard for this particular ssid
-} scan_result_t;
-
-// Manually construct the probe request frame, from inject.c
-static uint8_t probe_request[64] = {
-    0x40, 0x00,                         // Frame Control (0x40 = probe request)
-    0x00, 0x00,                         // Duration
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // Destination MAC (broadcast)
-    0x84, 0xF7, 0x03, 0x07, 0xC3, 0x10, // Source MAC (ESP32's MAC address)
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // BSSID (broadcast)
-    0x00, 0x00,                         // Sequence Control
-
-    // SSID Information Element
-    0x00, 0x00, // SSID Element ID (0x00), Length (0 for wildcard SSID)
-
-    // Supported Rates Information Element
-    0x01, 0x08, 0x82, 0x84, 0x8B, 0x96, 0x12, 0x24, 0x48, 0x6C, // Supported Rates (1, 2, 5.5, 11, 18, 36, 72, 96 Mbps)
-
-    // Extended Supported Rates Information Element
-    0x32, 0x04, 0x0C, 0x18, 0x30, 0x60 // Extended Supported Rates (6, 12, 24, 54 Mbps)
-};
+// Probe request templates with our STA MAC, built once the Wi-Fi stack is up
+static probe_builder_t probe_builder;
 
 static const char *PRINT = "[ PRINT ]";
-// static const char *DEBUG = "[ DEBUG ]";
 
-static DRAM_ATTR scan_result_t *scan_results = NULL; // Hash table for storing unique scan results, from inject.c
+static result_table_t scan_results; // BSSID table for storing unique scan results, scan_rx_task only
 
-static int num_scan_results = 0;
+static uint16_t scan_sweep = 0; // Scan cycle counter, entries from older cycles are evicted first
 
-static const uint8_t wifi_channels[NUM_CHANNELS] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
-static int curr_chan_idx = 0;
+// How sweeps are run, see scan_engine.h. A sweep keeps the backend it started with.
+static volatile scan_backend_t next_backend = SCAN_BACKEND;
+static scan_backend_t sweep_backend = SCAN_BACKEND;
+static uint16_t sweep_probes = 0;         // probe requests we sent this sweep
+static uint16_t sweep_probe_failures = 0; // probe requests the driver refused this sweep
 
-static bool scan_finish = false;
+// Reporting what changed in the table, see result_delta.h
+static volatile bool snapshot_requested = true; // the first report is always a full snapshot
+static uint16_t sweeps_since_snapshot = 0;
+static uint16_t sweeps_since_reset = 0;
 
-// Debug Function to print all entries in the hash set
-static inline void IRAM_ATTR print_scan_results()
+// Visit order for the current sweep, busiest channels first, see chan_sched.c
+static chan_sched_t chan_scheduler;
+static uint8_t chan_plan[NUM_CHANNELS];
+static int chan_plan_len = 0;
+static int chan_plan_pos = 0;
+static int curr_chan_idx = 0; // channel - 1, index into the per-channel arrays
+
+static bool scan_finish = false;
+static bool target_seen = false; // a probe response for WIFI_SSID was heard, end the sweep early
+static uint8_t target_bssid[6];   // who answered, handed to the connect step
+static uint8_t target_channel = 0;
+
+static int64_t scan_end_us = 0; // when the sweep finished, for the scan end -> got IP latency
+static bool sta_started = false; // connect issued, the GOT_IP handler is registered
+static const char *connect_hint = "driver rescan"; // where the last connect got its bssid/channel from, for the log
+
+// Sweep history in flash, see scan_store.h
+static scan_store_t scan_store;
+static uint16_t sweeps_since_store = 0;
+static uint8_t stored_target_bssid[6]; // connect target in the newest stored record
+static uint8_t stored_target_channel = 0;
+static uint8_t warm_bssid[6]; // connect target remembered from before the reset, 0 channel if none
+static uint8_t warm_channel = 0;
+
+// Per-channel discovery history, kept across scan cycles to size the dwell on each channel
+typedef struct chan_history_t
 {
-    scan_result_t *current_entry, *tmp;
+    uint16_t visits;      // times we have dwelled on this channel
+    uint16_t found;       // new BSSIDs found on the current visit
+    uint16_t activity;    // EWMA of new BSSIDs per visit, Q4 fixed point
+    uint32_t total_found; // new BSSIDs found here since boot
+    uint32_t probes_sent; // probe requests transmitted here since boot
+    uint32_t responses;   // probe responses addressed to us heard here since boot
+    latency_hist_t switch_lat; // esp_wifi_set_channel to this channel
+    latency_hist_t probe_rtt;  // start of a probe burst to the first response addressed to us
+    uint16_t beacon_int;       // longest beacon interval (TU) of the APs on this channel, 0 until heard
+    uint32_t beacons;          // AP beacons heard for this channel since boot
+} chan_history_t;
+
+#define CHAN_ACTIVITY_FULL (4 << 4) // 4 new BSSIDs per visit earns the full CHAN_DWELL_TIME
+
+// An expiry that was already queued when its timer got stopped or re-armed is stale, the handler
+// drops it because the deadline it goes by is not due yet, or is NO_DEADLINE once the timer is cancelled
+#define NO_DEADLINE INT64_MAX
+
+static chan_history_t chan_history[NUM_CHANNELS];
+static int64_t chan_enter_us = 0;                // when we tuned to the current channel
+static int64_t chan_deadline_us = NO_DEADLINE;   // when the dwell on the current channel ends, NO_DEADLINE until it starts
+static int64_t last_discovery_us = -1; // last new BSSID on the current channel, -1 for none yet
+
+// Time since sweep start at which each new BSSID was found, for the discovery latency report
+static int64_t sweep_start_us = 0;
+static uint32_t discovery_ms[MAX_DISCOVERIES];
+static uint16_t num_discoveries = 0;
+
+// Background scanning while associated: the sweep leaves the AP's channel in windows of at most
+// BG_OFF_CHAN_TIME and goes back for BG_HOME_DWELL_TIME in between, like the driver's
+// home_chan_dwell_time (see scan_config in scan_driver.c)
+static uint8_t home_chan = 0;         // channel of the associated AP, 0 when the sweep runs unassociated
+static volatile bool at_home = false; // back on home_chan between two off-channel windows
+static int64_t away_since_us = 0;     // start of the current off-channel window
+static uint32_t bg_windows = 0;       // off-channel windows this sweep
+static int64_t bg_away_us = 0;        // time spent off home_chan this sweep
+static latency_hist_t bg_away_lat;    // length of each off-channel window, since boot
+
+// Probe burst in progress on the current channel
+#define BURST_LISTEN_TIME ((NUM_PROBES - 1) * PROBE_INTERVAL + PROBE_DELAY) // last probe + time for its answers
+static int burst_probes_left = 0;
+static volatile bool burst_answered = false; // set by the RX task, the burst timer stops itself
+static int64_t burst_start_us = -1;          // first probe of the burst on the current channel, -1 if none
+
+// Frames sniffed by listen_handler, drained by scan_rx_task
+static DRAM_ATTR frame_ring_t rx_ring;
+static TaskHandle_t scan_rx_task_handle;
+
+// Timer expiries handed to scan_rx_task. The esp_timer callbacks only set a bit here, every timer
+// is started and stopped and all sweep state is changed on scan_rx_task alone.
+#define SCAN_EVENT_PROBE_DELAY 0x01
+#define SCAN_EVENT_CHAN_DWELL 0x02
+#define SCAN_EVENT_BURST 0x04
+#define SCAN_EVENT_SWEEP 0x08
+static atomic_uint scan_events;
+
+// Deadlines of the armed timers, see NO_DEADLINE
+static int64_t probe_deadline_us = NO_DEADLINE; // end of the probe delay on the current channel
+static int64_t burst_next_us = NO_DEADLINE;     // next probe of the burst in progress
 
-    // Iterate over the hash set and print each entry
-    HASH_ITER(hh, scan_results, current_entry, tmp)
-    {
-        printf("BSSID: %02x:%02x:%02x:%02x:%02x:%02x, SSID: %s, Channel: %d, RSSI: %d dBm\n",
-               current_entry->bssid[0], current_entry->bssid[1], current_entry->bssid[2],
-               current_entry->bssid[3], current_entry->bssid[4], current_entry->bssid[5],
-               current_entry->ssid, current_entry->channel, current_entry->rssi);
-    }
-}
 /************************************************************
  *                 TIMERS AND CALLBACKS                     *
  *                                                          *
  ************************************************************/
 
-// Handler for Wi-Fi and IP events
-// static void event_handler(
-//     void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
-// {
-//     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
-//     {
-//         esp_wifi_connect();
-//         ESP_LOGI(TAG, "Connecting to AP...");
-//     }
-//     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
-//     {
-//         ESP_LOGW(TAG, "Disconnected. Reconnecting...");
-//         esp_wifi_connect();
-//     }
-//     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
-//     {
-//         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-//         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
-//     }
-// }
-
 static void init_timers()
 {
     // Probe delay timer
@@ -131,8 +230,7 @@ static void init_timers()
         .callback = &probe_timer_cb,       // Callback function
         .arg = NULL,                       // Argument passed to the callback
         .dispatch_method = ESP_TIMER_TASK, // ESP_TIMER_ISR does not seem to be supported for version 5.x
-        // .dispatch_method = ESP_TIMER_ISR, // Call callback in a task context
-        .name = "probe_delay_timer" // Name of the timer (for debugging)
+        .name = "probe_delay_timer"        // Name of the timer (for debugging)
     };
     ESP_ERROR_CHECK(esp_timer_create(&probe_timer_args, &probe_timer_handler));
 
@@ -141,10 +239,257 @@ static void init_timers()
         .callback = &chanDwell_timer_cb,   // Callback function
         .arg = NULL,                       // Argument passed to the callback
         .dispatch_method = ESP_TIMER_TASK, // ESP_TIMER_ISR does not seem to be supported for version 5.x
-        // .dispatch_method = ESP_TIMER_ISR, // Call callback in a task context
-        .name = "chan_dwell_timer" // Name of the timer (for debugging)
+        .name = "chan_dwell_timer"         // Name of the timer (for debugging)
     };
     ESP_ERROR_CHECK(esp_timer_create(&chanDwell_timer_args, &chanDwell_timer_handler));
+
+    // Probe burst timer, periodic every PROBE_INTERVAL while a burst is in progress
+    esp_timer_create_args_t burst_timer_args = {
+        .callback = &burst_timer_cb,       // Callback function
+        .arg = NULL,                       // Argument passed to the callback
+        .dispatch_method = ESP_TIMER_TASK, // ESP_TIMER_ISR does not seem to be supported for version 5.x
+        .name = "probe_burst_timer"        // Name of the timer (for debugging)
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&burst_timer_args, &burst_timer_handler));
+
+    // Sweep timer, starts the next sweep SCAN_INTERVAL after the previous one finished
+    esp_timer_create_args_t sweep_timer_args = {
+        .callback = &sweep_timer_cb,       // Callback function
+        .arg = NULL,                       // Argument passed to the callback
+        .dispatch_method = ESP_TIMER_TASK, // ESP_TIMER_ISR does not seem to be supported for version 5.x
+        .name = "scan_sweep_timer"         // Name of the timer (for debugging)
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&sweep_timer_args, &sweep_timer_handler));
+}
+
+// Per-channel probe/response counts, to tune NUM_PROBES against discovery rate and airtime
+static void print_chan_stats()
+{
+    for (int i = 0; i < chan_plan_len; i++)
+    {
+        const chan_history_t *hist = &chan_history[chan_plan[i] - 1];
+        ESP_LOGI(PRINT, "CHAN %2d: %u probes sent, %u responses, %u beacons (interval %u TU), %u new BSSIDs over %u visits",
+                 chan_plan[i], (unsigned)hist->probes_sent, (unsigned)hist->responses, (unsigned)hist->beacons,
+                 hist->beacon_int, (unsigned)hist->total_found, hist->visits);
+    }
+}
+
+// Per-channel p50/p99 of the channel switch and probe round trip, accumulated since boot
+static void print_latency_stats()
+{
+    for (int i = 0; i < chan_plan_len; i++)
+    {
+        const chan_history_t *hist = &chan_history[chan_plan[i] - 1];
+        ESP_LOGI(PRINT, "LATENCY CHAN %2d: switch p50 %u us p99 %u us (%u), probe rtt p50 %u us p99 %u us (%u)",
+                 chan_plan[i],
+                 (unsigned)latency_hist_percentile(&hist->switch_lat, 50),
+                 (unsigned)latency_hist_percentile(&hist->switch_lat, 99),
+                 (unsigned)latency_hist_count(&hist->switch_lat),
+                 (unsigned)latency_hist_percentile(&hist->probe_rtt, 50),
+                 (unsigned)latency_hist_percentile(&hist->probe_rtt, 99),
+                 (unsigned)latency_hist_count(&hist->probe_rtt));
+    }
+}
+
+// Order this sweep's channels by past discoveries, skipping channels the country does not allow
+static void build_chan_plan()
+{
+    wifi_country_t country;
+    ESP_ERROR_CHECK(esp_wifi_get_country(&country));
+
+    chan_plan_len = chan_sched_plan(&chan_scheduler, country.schan, country.nchan, chan_plan);
+    chan_plan_pos = 0;
+    curr_chan_idx = chan_plan[0] - 1;
+
+    char plan_str[NUM_CHANNELS * 3 + 1];
+    int n = 0;
+    for (int i = 0; i < chan_plan_len; i++)
+    {
+        n += snprintf(plan_str + n, sizeof(plan_str) - n, " %d", chan_plan[i]);
+    }
+    ESP_LOGI(PRINT, "CHANNEL PLAN:%s", plan_str);
+}
+
+// Base dwell for a channel. Channels with no history keep the fixed default for how we got here,
+// channels we have visited get between CHAN_MIN_DWELL_TIME and CHAN_DWELL_TIME depending on how
+// many new BSSIDs they turned up in the past.
+static uint32_t chan_dwell_time(int chan_idx, uint32_t default_ms)
+{
+    const chan_history_t *hist = &chan_history[chan_idx];
+    if (hist->visits == 0)
+    {
+        return default_ms;
+    }
+
+    uint32_t activity = hist->activity > CHAN_ACTIVITY_FULL ? CHAN_ACTIVITY_FULL : hist->activity;
+    return CHAN_MIN_DWELL_TIME + (CHAN_DWELL_TIME - CHAN_MIN_DWELL_TIME) * activity / CHAN_ACTIVITY_FULL;
+}
+
+// Latest the dwell on the current channel may end: CHAN_MAX_DWELL_TIME after entering it, and while
+// associated no later than the end of the off-channel window
+static int64_t chan_dwell_limit()
+{
+    int64_t limit = chan_enter_us + CHAN_MAX_DWELL_TIME * 1000;
+    if (home_chan && away_since_us + BG_OFF_CHAN_TIME * 1000 < limit)
+    {
+        limit = away_since_us + BG_OFF_CHAN_TIME * 1000;
+    }
+    return limit;
+}
+
+// Stop a timer that may have expired on its own since we last looked: esp_timer_stop reports
+// ESP_ERR_INVALID_STATE for a timer that is not armed, which is not an error here.
+// Returns true when the timer was still armed and is now stopped.
+static bool stop_timer(esp_timer_handle_t timer)
+{
+    esp_err_t err = esp_timer_stop(timer);
+    if (err != ESP_ERR_INVALID_STATE)
+    {
+        ESP_ERROR_CHECK(err);
+    }
+    return err == ESP_OK;
+}
+
+// Leaving the channel: drop the probe delay, and its expiry too if that is already queued
+static void cancel_probe_delay()
+{
+    stop_timer(probe_timer_handler);
+    probe_deadline_us = NO_DEADLINE;
+}
+
+// (Re)arm the chanDwell timer so it expires at chan_deadline_us
+static void arm_chan_dwell(int64_t now)
+{
+    stop_timer(chanDwell_timer_handler);
+    int64_t remaining = chan_deadline_us > now ? chan_deadline_us - now : 0;
+    ESP_ERROR_CHECK(esp_timer_start_once(chanDwell_timer_handler, remaining));
+}
+
+// Start dwelling on the current channel, a recent discovery keeps us here for at least CHAN_QUIET_TIME
+static void start_chan_dwell(uint32_t default_ms)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t deadline = now + (int64_t)chan_dwell_time(curr_chan_idx, default_ms) * 1000;
+
+    if (last_discovery_us >= 0 && last_discovery_us + CHAN_QUIET_TIME * 1000 > deadline)
+    {
+        deadline = last_discovery_us + CHAN_QUIET_TIME * 1000;
+    }
+    if (deadline > chan_dwell_limit())
+    {
+        deadline = chan_dwell_limit();
+    }
+    chan_deadline_us = deadline;
+    arm_chan_dwell(now);
+}
+
+// Passive sweeps stay long enough on each channel to hear every AP beacon once: the longest beacon
+// interval seen on the channel, DEFAULT_BEACON_INT until we know better. The sweep time only depends
+// on what the APs advertise, not on how busy a channel turns out to be.
+static uint32_t passive_dwell_time(int chan_idx)
+{
+    uint32_t tu = chan_history[chan_idx].beacon_int ? chan_history[chan_idx].beacon_int : DEFAULT_BEACON_INT;
+    uint32_t ms = tu * 1024 / 1000 + PASSIVE_DWELL_MARGIN;
+    return ms > CHAN_MAX_DWELL_TIME ? CHAN_MAX_DWELL_TIME : ms;
+}
+
+static void start_passive_dwell()
+{
+    int64_t deadline = chan_enter_us + (int64_t)passive_dwell_time(curr_chan_idx) * 1000;
+    if (deadline > chan_dwell_limit())
+    {
+        deadline = chan_dwell_limit();
+    }
+    chan_deadline_us = deadline;
+    arm_chan_dwell(esp_timer_get_time());
+}
+
+// Shortest visit worth leaving home for, the next channel's beacon interval or a probe delay and a full burst
+static uint32_t min_visit_time()
+{
+    if (sweep_backend == SCAN_BACKEND_SNIFF)
+    {
+        return passive_dwell_time(chan_plan[chan_plan_pos + 1] - 1);
+    }
+    return PROBE_DELAY + BURST_LISTEN_TIME;
+}
+
+// Keep dwelling until at least deadline (bounded by chan_dwell_limit), e.g. to hear out a probe burst
+static void extend_chan_dwell(int64_t deadline)
+{
+    if (deadline > chan_dwell_limit())
+    {
+        deadline = chan_dwell_limit();
+    }
+    if (deadline > chan_deadline_us)
+    {
+        chan_deadline_us = deadline;
+        arm_chan_dwell(esp_timer_get_time());
+    }
+}
+
+// A new BSSID turned up on the current channel, stay until it has been quiet for CHAN_QUIET_TIME
+static void note_chan_discovery()
+{
+    int64_t now = esp_timer_get_time();
+
+    chan_history[curr_chan_idx].found += 1;
+    chan_history[curr_chan_idx].total_found += 1;
+    last_discovery_us = now;
+    if (num_discoveries < MAX_DISCOVERIES)
+    {
+        discovery_ms[num_discoveries++] = (uint32_t)((now - sweep_start_us) / 1000);
+    }
+
+    // dwell not started yet (still in probe delay), start_chan_dwell will account for this discovery.
+    // Passive sweeps keep their fixed dwell.
+    if (chan_deadline_us == NO_DEADLINE || sweep_backend == SCAN_BACKEND_SNIFF)
+    {
+        return;
+    }
+
+    int64_t deadline = now + CHAN_QUIET_TIME * 1000;
+    if (deadline > chan_dwell_limit())
+    {
+        deadline = chan_dwell_limit();
+    }
+    if (deadline > chan_deadline_us)
+    {
+        chan_deadline_us = deadline;
+        arm_chan_dwell(now);
+        SCAN_TRACE_EVENT(TRACE_DWELL_EXTENDED, curr_chan_idx + 1, (uint16_t)((deadline - chan_enter_us) / 1000));
+    }
+}
+
+// Fold the visit that just ended into the channel's history
+static void close_chan_visit(int chan_idx)
+{
+    chan_history_t *hist = &chan_history[chan_idx];
+    uint32_t found = hist->found > 255 ? 255 : hist->found;
+
+    chan_sched_record(&chan_scheduler, chan_idx + 1, hist->found);
+
+    // activity += (found - activity) / 4, in Q4
+    hist->activity = hist->activity - hist->activity / 4 + (found << 4) / 4;
+    hist->visits += 1;
+    hist->found = 0;
+}
+
+// Log how long it took to find 50/90/100% of the BSSIDs discovered this sweep
+static void print_discovery_latency()
+{
+    uint32_t sweep_ms = (uint32_t)((esp_timer_get_time() - sweep_start_us) / 1000);
+    if (num_discoveries == 0)
+    {
+        ESP_LOGI(PRINT, "DISCOVERY: no new BSSIDs in %u ms", (unsigned)sweep_ms);
+        return;
+    }
+
+    ESP_LOGI(PRINT, "DISCOVERY: %u BSSIDs in %u ms sweep, 50%% by %u ms, 90%% by %u ms, 100%% by %u ms",
+             num_discoveries, (unsigned)sweep_ms,
+             (unsigned)discovery_ms[(num_discoveries * 50 + 99) / 100 - 1],
+             (unsigned)discovery_ms[(num_discoveries * 90 + 99) / 100 - 1],
+             (unsigned)discovery_ms[num_discoveries - 1]);
 }
 
 static void switch_to_next_channel()
@@ -154,222 +499,772 @@ static void switch_to_next_channel()
         return;
     }
 
-    if (curr_chan_idx >= NUM_CHANNELS - 1)
+    close_chan_visit(curr_chan_idx);
+
+    if (target_seen || chan_plan_pos >= chan_plan_len - 1)
     {
         finished_dynamo_probe();
         return;
     }
-    curr_chan_idx += 1;
 
-    uint8_t next_chan = wifi_channels[curr_chan_idx];
+    // associated: go back to the AP once the window has no room left for a full visit
+    if (home_chan && esp_timer_get_time() + min_visit_time() * 1000 > away_since_us + BG_OFF_CHAN_TIME * 1000)
+    {
+        start_home_dwell();
+        return;
+    }
+    tune_to_next_channel(curr_chan_idx + 1);
+}
 
-    ESP_ERROR_CHECK(esp_wifi_set_channel(next_chan, WIFI_SECOND_CHAN_NONE)); // switch channels
-    // ESP_LOGI(PRINT, "Channel switched to %d : ", next_chan);
+// Close the off-channel window that started at away_since_us
+static void end_away_window(int64_t now)
+{
+    bg_away_us += now - away_since_us;
+    latency_hist_record(&bg_away_lat, (uint32_t)(now - away_since_us));
+}
 
-    // restart the probe delay timer on duration PROBE_DELAY because we finished scanning this channel
-    if (esp_timer_is_active(probe_timer_handler))
+// Spend BG_HOME_DWELL_TIME on the AP's channel so the link can catch up, chanDwell_timer_cb resumes the sweep
+static void start_home_dwell()
+{
+    int64_t now = esp_timer_get_time();
+    end_away_window(now);
+
+    stop_probe_burst();
+    cancel_probe_delay();
+    SCAN_TRACE_EVENT(TRACE_CHAN_LEAVE, curr_chan_idx + 1, home_chan);
+    at_home = true;
+    ESP_ERROR_CHECK(esp_wifi_set_channel(home_chan, WIFI_SECOND_CHAN_NONE));
+    SCAN_TRACE_EVENT(TRACE_HOME_DWELL, home_chan, BG_HOME_DWELL_TIME);
+    chan_deadline_us = now + BG_HOME_DWELL_TIME * 1000;
+    arm_chan_dwell(now);
+}
+
+// Tune to the next channel of the plan and start listening there
+static void start_chan_visit()
+{
+    if (sweep_backend == SCAN_BACKEND_SNIFF)
     {
-        ESP_ERROR_CHECK(esp_timer_stop(probe_timer_handler));
+        start_passive_dwell();
+        return;
     }
-    ESP_LOGI(PRINT, "RESTART PROBE TIMER ON CHAN %d", next_chan);
+    // probe delay, a frame heard before it expires starts the dwell without probing
+    probe_deadline_us = esp_timer_get_time() + PROBE_DELAY * 1000;
     ESP_ERROR_CHECK(esp_timer_start_once(probe_timer_handler, PROBE_DELAY * 1000)); // 1,000,000 microseconds = 1 second, this value is PROBE_DELAY ms
 }
 
-static void send_probe_request()
+static void tune_to_next_channel(uint8_t from_chan)
 {
-    ESP_ERROR_CHECK(esp_wifi_80211_tx(WIFI_IF_STA, probe_request, sizeof(probe_request), false));
-    ESP_LOGI(PRINT, "Wildcard probe request sent. Channel : %d ", wifi_channels[curr_chan_idx]);
+    chan_plan_pos += 1;
+
+    uint8_t next_chan = chan_plan[chan_plan_pos];
+    SCAN_TRACE_EVENT(TRACE_CHAN_LEAVE, from_chan, next_chan);
+    curr_chan_idx = next_chan - 1;
+
+    stop_probe_burst();
+    int64_t switch_start_us = esp_timer_get_time();
+    ESP_ERROR_CHECK(esp_wifi_set_channel(next_chan, WIFI_SECOND_CHAN_NONE)); // switch channels
+    chan_enter_us = esp_timer_get_time();
+    latency_hist_record(&chan_history[curr_chan_idx].switch_lat, (uint32_t)(chan_enter_us - switch_start_us));
+    last_discovery_us = -1;
+    burst_start_us = -1;
+    chan_deadline_us = NO_DEADLINE;
+
+    // restart the probe delay timer on duration PROBE_DELAY because we finished scanning this channel
+    cancel_probe_delay();
+    SCAN_TRACE_EVENT(TRACE_CHAN_SWITCH, next_chan, next_chan);
+    start_chan_visit();
 }
 
-// triggered when probe_delay expires without being interrupted by listen event
-static void probe_timer_cb()
+static void send_probe_request()
 {
-    ESP_LOGI(PRINT, "PROBE DELAY EXPIRED");
-    if (scan_finish)
+    uint16_t len;
+    // once associated, later sweeps refresh the whole table, so ask every AP to answer
+    bool directed = TARGETED_SCAN && !home_chan;
+    const uint8_t *frame = probe_builder_frame(&probe_builder, directed, PROBE_RATE_SET, &len);
+
+    // the driver numbers the frame, it refuses raw frames with our own sequence number once associated
+    esp_err_t err = esp_wifi_80211_tx(WIFI_IF_STA, frame, len, true);
+    if (err != ESP_OK)
     {
+        // not fatal, e.g. the TX queue is full, the burst carries on and the channel still gets its listen time
+        ESP_LOGW(PRINT, "PROBE TX FAILED on channel %d: %s", curr_chan_idx + 1, esp_err_to_name(err));
+        sweep_probe_failures += 1;
         return;
     }
-    // probeDelay expires, trigger an active probe on curr channel
+    sweep_probes += 1;
+    chan_history[curr_chan_idx].probes_sent += 1;
+    SCAN_TRACE_EVENT(TRACE_PROBE_SENT, curr_chan_idx + 1, directed);
+}
+
+// Send the first probe of a burst, the rest follow every PROBE_INTERVAL from burst_timer_cb
+static void start_probe_burst()
+{
+    burst_answered = false;
+    burst_probes_left = NUM_PROBES - 1;
+    burst_start_us = esp_timer_get_time();
+    burst_next_us = burst_start_us + PROBE_INTERVAL * 1000;
+
     send_probe_request();
 
-    // // Start chan dwell timer to dwell on this channel, if we have not already
-    // if (!esp_timer_is_active(chanDwell_timer_handler))
-    // {
-    //     ESP_ERROR_CHECK(esp_timer_start_once(chanDwell_timer_handler, CHAN_DWELL_TIME * 1000)); // 1,000,000 microseconds = 1 second, this value is CHAN_DWELL_TIME ms
-    // }
+    if (burst_probes_left > 0)
+    {
+        ESP_ERROR_CHECK(esp_timer_start_periodic(burst_timer_handler, PROBE_INTERVAL * 1000));
+    }
+}
+
+static void stop_probe_burst()
+{
+    burst_probes_left = 0;
+    burst_next_us = NO_DEADLINE;
+    stop_timer(burst_timer_handler);
+}
 
-    // refresh chanDwell timer, in case we started it before probe_delay expired
-    if (esp_timer_is_active(chanDwell_timer_handler))
+// every PROBE_INTERVAL during a burst
+static void burst_tick()
+{
+    if (esp_timer_get_time() < burst_next_us)
     {
-        ESP_ERROR_CHECK(esp_timer_stop(chanDwell_timer_handler));
+        return; // left over from a burst that has been stopped since
     }
+    burst_next_us += PROBE_INTERVAL * 1000;
 
-    if (!esp_timer_is_active(chanDwell_timer_handler))
+    if (scan_finish || burst_answered || burst_probes_left <= 0)
     {
-        ESP_LOGI(PRINT, "START CHAN DWELL LISTENING AFTER SENDING PROBE");
-        ESP_ERROR_CHECK(esp_timer_start_once(chanDwell_timer_handler, PROBE_DELAY * 1000)); // 1,000,000 microseconds = 1 second, this value is PROBE_DELAY ms
+        // an AP answered, the remaining probes would only cost airtime
+        stop_probe_burst();
+        return;
     }
 
-    // // start probeDelay timer again for next channel
-    // if (esp_timer_is_active(probe_timer_handler))
-    // {
-    //     ESP_ERROR_CHECK(esp_timer_stop(probe_timer_handler));
-    // }
-    // ESP_ERROR_CHECK(esp_timer_start_once(probe_timer_handler, PROBE_DELAY * 1000)); // 1,000,000 microseconds = 1 second, this value is PROBE_DELAY
+    send_probe_request();
+    burst_probes_left -= 1;
+    if (burst_probes_left == 0)
+    {
+        stop_probe_burst();
+    }
 }
 
-// triggered when chanDwell expires
-static void chanDwell_timer_cb()
+// probe delay expired without being interrupted by listen event
+static void probe_delay_expired()
+{
+    if (esp_timer_get_time() < probe_deadline_us)
+    {
+        return; // cancelled or re-armed since
+    }
+    probe_deadline_us = NO_DEADLINE;
+    SCAN_TRACE_EVENT(TRACE_PROBE_DELAY_EXPIRED, curr_chan_idx + 1, 0);
+    if (scan_finish)
+    {
+        return;
+    }
+    // probeDelay expires, trigger a burst of active probes on curr channel
+    start_probe_burst();
+
+    // (re)start the dwell from here, start_chan_dwell re-arms the timer
+    SCAN_TRACE_EVENT(TRACE_DWELL_AFTER_PROBE, curr_chan_idx + 1, 0);
+    start_chan_dwell(PROBE_DELAY); // without history, listen for responses for PROBE_DELAY ms
+
+    // stay at least until the last probe of the burst has had time to be answered
+    extend_chan_dwell(esp_timer_get_time() + BURST_LISTEN_TIME * 1000);
+}
+
+// dwell on the current channel (or back home) is over
+static void chan_dwell_expired()
 {
-    ESP_LOGI(PRINT, "CHAN DWELL EXPIRED");
+    if (esp_timer_get_time() < chan_deadline_us)
+    {
+        return; // extended, or we moved on and the next dwell has not started yet
+    }
+    chan_deadline_us = NO_DEADLINE;
+    SCAN_TRACE_EVENT(TRACE_DWELL_EXPIRED, curr_chan_idx + 1, 0);
     if (scan_finish)
     {
         return;
     }
 
+    if (at_home)
+    {
+        // home dwell over, open the next off-channel window
+        at_home = false;
+        away_since_us = esp_timer_get_time();
+        bg_windows += 1;
+        tune_to_next_channel(home_chan);
+        return;
+    }
+
     // switch channel, only in chanDwell because we want to dwell on the channel after sending a probe, or hear a probe being transmitted
     switch_to_next_channel();
 }
 
-static void finished_dynamo_probe()
+// The esp_timer callbacks run in the esp_timer task, hand the work over to scan_rx_task
+static void post_scan_event(unsigned event)
 {
+    atomic_fetch_or(&scan_events, event);
+    xTaskNotifyGive(scan_rx_task_handle);
+}
 
-    // bool flag control for a single scan event
-    if (scan_finish)
+static void probe_timer_cb()
+{
+    post_scan_event(SCAN_EVENT_PROBE_DELAY);
+}
+
+static void chanDwell_timer_cb()
+{
+    post_scan_event(SCAN_EVENT_CHAN_DWELL);
+}
+
+static void burst_timer_cb()
+{
+    post_scan_event(SCAN_EVENT_BURST);
+}
+
+// triggered SCAN_INTERVAL after a sweep finished
+static void sweep_timer_cb()
+{
+    post_scan_event(SCAN_EVENT_SWEEP);
+}
+
+// Strongest entry for WIFI_SSID that answered a probe, NULL if none did. Compared on smoothed RSSI,
+// a single frame caught in a fade or on a lucky multipath peak says little about the link.
+static const scan_result_t *best_connect_candidate()
+{
+    const scan_result_t *best = NULL;
+    scan_result_t *entry;
+    int cursor = 0;
+
+    while ((entry = bssid_table_next(&scan_results.index, &cursor)) != NULL)
+    {
+        if (!entry->recvResponse || strcmp((const char *)entry->ssid, WIFI_SSID) != 0)
+        {
+            continue;
+        }
+        if (!best || rssi_stats_avg(&entry->stats) > rssi_stats_avg(&best->stats))
+        {
+            best = entry;
+        }
+    }
+    return best;
+}
+
+static void got_ip_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    (void)arg;
+    (void)event_base;
+    (void)event_id;
+    ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+    uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - scan_end_us) / 1000);
+
+    ESP_LOGI(PRINT, "Got IP: " IPSTR ", %u ms after scan end (%s)", IP2STR(&event->ip_info.ip),
+             (unsigned)latency_ms, connect_hint);
+}
+
+// Where to find WIFI_SSID: the AP we are associated with, else the strongest responder in the table,
+// else the one that ended a targeted sweep, else what the stored history remembers. Returns where
+// the target came from, NULL if there is none.
+static const char *connect_target(uint8_t *bssid, uint8_t *channel)
+{
+    wifi_ap_record_t ap;
+    const scan_result_t *best;
+
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK)
+    {
+        memcpy(bssid, ap.bssid, 6);
+        *channel = ap.primary;
+        return "associated";
+    }
+    if ((best = best_connect_candidate()) != NULL)
+    {
+        memcpy(bssid, best->bssid, 6);
+        *channel = best->channel;
+        return "bssid/channel from scan";
+    }
+    if (target_seen)
+    {
+        memcpy(bssid, target_bssid, 6);
+        *channel = target_channel;
+        return "bssid/channel from scan";
+    }
+    if (warm_channel)
+    {
+        memcpy(bssid, warm_bssid, 6);
+        *channel = warm_channel;
+        return "bssid/channel from flash";
+    }
+    return NULL;
+}
+
+static const wifi_config_t sta_config = {
+    .sta = {
+        .ssid = WIFI_SSID,
+        .password = WIFI_PASS,
+        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+    },
+};
+
+// Hand the config to the driver and start joining. Errors are not fatal, the driver may still be
+// busy with an earlier connect or disconnect. Still unassociated, the next sweep ends with another connect.
+static esp_err_t start_connect(wifi_config_t *wifi_config)
+{
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, wifi_config);
+    if (err == ESP_OK)
+    {
+        err = esp_wifi_connect();
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(PRINT, "CONNECT FAILED: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+// Join WIFI_SSID, using what a sweep (or the stored history) found to skip the driver's own scan
+static void connect_sta()
+{
+    // the stack is already started in STA mode, connecting does not need a restart
+    wifi_config_t wifi_config = sta_config;
+
+#if CONNECT_WITH_SCAN_HINT
+    // we already know who answers for WIFI_SSID and where, skip the driver's own scan
+    const char *source = connect_target(wifi_config.sta.bssid, &wifi_config.sta.channel);
+    if (source)
+    {
+        connect_hint = source;
+        wifi_config.sta.bssid_set = true;
+        ESP_LOGI(PRINT, "CONNECT TARGET " MACSTR " ON CHAN %d (%s)", MAC2STR(wifi_config.sta.bssid),
+                 wifi_config.sta.channel, source);
+    }
+#endif
+    if (!sta_started)
+    {
+        ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip_handler, NULL));
+    }
+    sta_started = true;
+    if (start_connect(&wifi_config) == ESP_OK)
+    {
+        ESP_LOGI(PRINT, "Connecting to AP...");
+    }
+}
+
+#if ROAM_TO_STRONGER_AP
+// After a background sweep, move to the best candidate for WIFI_SSID if it beats the associated AP
+// by ROAM_MARGIN. Both sides are smoothed RSSI, so one good frame does not make us drop the link.
+static void roam_to_stronger_ap()
+{
+    wifi_ap_record_t ap;
+    const scan_result_t *best = best_connect_candidate();
+    if (!best || best->stats.samples < ROAM_MIN_SAMPLES || esp_wifi_sta_get_ap_info(&ap) != ESP_OK ||
+        memcmp(best->bssid, ap.bssid, 6) == 0)
     {
         return;
     }
-    scan_finish = true;
-    ESP_LOGI(PRINT, "FINISHED SCANNING");
 
-    if (esp_timer_is_active(probe_timer_handler))
+    // what we heard from the AP ourselves beats the driver's last beacon reading
+    const scan_result_t *current = bssid_table_find(&scan_results.index, bssid_key(ap.bssid));
+    int current_rssi = current ? rssi_stats_avg(&current->stats) : ap.rssi;
+    int best_rssi = rssi_stats_avg(&best->stats);
+    if (best_rssi < current_rssi + ROAM_MARGIN)
     {
-        ESP_ERROR_CHECK(esp_timer_stop(probe_timer_handler));
+        return;
     }
 
-    if (esp_timer_is_active(chanDwell_timer_handler))
+    ESP_LOGI(PRINT, "ROAM " MACSTR " (%d dBm) -> " MACSTR " ON CHAN %d (%d dBm, %d..%d over %u frames in %u ms)",
+             MAC2STR(ap.bssid), current_rssi, MAC2STR(best->bssid), best->channel, best_rssi,
+             best->stats.min, best->stats.max, best->stats.samples,
+             (unsigned)(best->stats.last_seen_ms - best->stats.first_seen_ms));
+
+    wifi_config_t wifi_config = sta_config;
+    memcpy(wifi_config.sta.bssid, best->bssid, 6);
+    wifi_config.sta.bssid_set = true;
+    wifi_config.sta.channel = best->channel;
+    esp_err_t err = esp_wifi_disconnect();
+    if (err != ESP_OK)
     {
-        ESP_ERROR_CHECK(esp_timer_stop(chanDwell_timer_handler));
+        ESP_LOGW(PRINT, "ROAM SKIPPED, disconnect failed: %s", esp_err_to_name(err));
+        return;
     }
-    ESP_LOGI(PRINT, "STOP ALL TIMERS");
-    ESP_ERROR_CHECK(esp_timer_delete(probe_timer_handler));
-    ESP_ERROR_CHECK(esp_timer_delete(chanDwell_timer_handler));
+    connect_hint = "roam";
+    // on failure we are left unassociated, the next sweep runs in the foreground and connects again
+    start_connect(&wifi_config);
+}
+#endif
 
-    esp_wifi_set_promiscuous(false);
-    ESP_LOGI(PRINT, "Disabled promiscuous mode");
-    esp_wifi_set_promiscuous_rx_cb(NULL);
+// Sweeps after the first hop away from the associated AP, tune back to it so the link carries on
+static void return_to_home_channel()
+{
+    if (!home_chan)
+    {
+        return; // the sweep ran unassociated, nothing to return to
+    }
+    if (!at_home)
+    {
+        end_away_window(esp_timer_get_time());
+    }
+    at_home = false;
+    ESP_ERROR_CHECK(esp_wifi_set_channel(home_chan, WIFI_SECOND_CHAN_NONE));
+
+    // a background sweep costs the link at most its share of airtime away, and adds at most one
+    // window of delay to frames queued for us
+    uint32_t sweep_ms = (uint32_t)((scan_end_us - sweep_start_us) / 1000);
+    uint32_t away_ms = (uint32_t)(bg_away_us / 1000);
+    ESP_LOGI(PRINT, "BACKGROUND: %u off-channel windows, away %u of %u ms (%u%% airtime lost to the link), "
+                    "window p50 %u ms p99 %u ms",
+             (unsigned)bg_windows, (unsigned)away_ms, (unsigned)sweep_ms,
+             (unsigned)(sweep_ms ? away_ms * 100 / sweep_ms : 0),
+             (unsigned)(latency_hist_percentile(&bg_away_lat, 50) / 1000),
+             (unsigned)(latency_hist_percentile(&bg_away_lat, 99) / 1000));
+
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK)
+    {
+        ESP_LOGI(PRINT, "BACK ON HOME CHAN %d, AP RSSI %d dBm", home_chan, ap.rssi);
+    }
+    else
+    {
+        ESP_LOGW(PRINT, "LINK LOST DURING BACKGROUND SWEEP");
+    }
+}
 
-    print_scan_results();
+void scan_engine_set_backend(scan_backend_t backend)
+{
+    if (backend < SCAN_BACKEND_COUNT)
+    {
+        next_backend = backend;
+    }
+}
 
-    // ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    // ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
+scan_backend_t scan_engine_backend(void)
+{
+    return next_backend;
+}
 
-    // restart wifi in STA mode
-    ESP_ERROR_CHECK(esp_wifi_stop());
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_start());
+const char *scan_backend_name(scan_backend_t backend)
+{
+    switch (backend)
+    {
+    case SCAN_BACKEND_PROBE:
+        return "probe";
+    case SCAN_BACKEND_SNIFF:
+        return "sniff";
+    case SCAN_BACKEND_DRIVER:
+        return "driver";
+    default:
+        return "?";
+    }
+}
 
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_connect());
-    ESP_LOGI(PRINT, "Connecting to AP...");
+// Driver backend: one esp_wifi_scan_start covers every channel, scan_rx_drain ends the sweep on SCAN_DONE
+static void start_driver_sweep()
+{
+    chan_plan_len = 0; // no per-channel visits of our own to report
+    SCAN_TRACE_EVENT(TRACE_SWEEP_START, 0, 0);
+    if (!scan_driver_start())
+    {
+        // try again with the next sweep
+        scan_finish = true;
+        ESP_ERROR_CHECK(esp_timer_start_once(sweep_timer_handler, (uint64_t)SCAN_INTERVAL * 1000));
+    }
+}
+
+// Probe and sniff backends: hop the channel plan with promiscuous mode on
+static void start_hop_sweep()
+{
+    build_chan_plan();
+    ESP_ERROR_CHECK(esp_wifi_set_channel(chan_plan[chan_plan_pos], WIFI_SECOND_CHAN_NONE));
+    last_discovery_us = -1;
+    burst_start_us = -1;
+    chan_deadline_us = NO_DEADLINE;
+
+    // the previous sweep left promiscuous mode off
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(listen_handler));
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
 
-    return;
+    // start probe delay timer, triggers active scan upon expiration if not interrupted by listen
+    chan_enter_us = esp_timer_get_time();
+    away_since_us = chan_enter_us;
+    SCAN_TRACE_EVENT(TRACE_SWEEP_START, curr_chan_idx + 1, chan_plan_len);
+    start_chan_visit();
 }
 
-/************************************************************
- *                SCAN RESULTS AND HASH                     *
- *                -Primarily sourced from inject.c          *
- ************************************************************/
+// Begin a sweep with the selected backend. Timers, the results table and the channel history carry
+// over from earlier sweeps, only the per-sweep state is reset here, and the table every
+// RESULT_RESET_EVERY sweeps.
+static void start_sweep()
+{
+    scan_sweep += 1; // entries not refreshed by this sweep become the first to be evicted
+    scan_finish = false;
+    target_seen = false;
+    num_discoveries = 0;
+    sweep_probes = 0;
+    sweep_probe_failures = 0;
+
+    // the table starts over now and then, this sweep fills it again and its report is a snapshot
+    sweeps_since_reset += 1;
+    if (RESULT_RESET_EVERY && sweeps_since_reset >= RESULT_RESET_EVERY)
+    {
+        sweeps_since_reset = 0;
+        result_table_clear(&scan_results);
+        ESP_LOGI(PRINT, "RESULTS TABLE RESET");
+    }
+
+    sweep_backend = next_backend;
+#if SCAN_BACKEND_ROTATE
+    next_backend = (scan_backend_t)((sweep_backend + 1) % SCAN_BACKEND_COUNT);
+#endif
+
+    // associated: scan in the background, in bounded windows away from the AP
+    wifi_ap_record_t ap;
+    home_chan = esp_wifi_sta_get_ap_info(&ap) == ESP_OK ? ap.primary : 0;
+    at_home = false;
+    bg_windows = home_chan ? 1 : 0;
+    bg_away_us = 0;
+    sweep_start_us = esp_timer_get_time();
+
+    ESP_LOGI(PRINT, "SWEEP %u STARTED%s [%s]", scan_sweep, home_chan ? " IN BACKGROUND" : "",
+             scan_backend_name(sweep_backend));
+    if (sweep_backend == SCAN_BACKEND_DRIVER)
+    {
+        start_driver_sweep();
+    }
+    else
+    {
+        start_hop_sweep();
+    }
+}
 
-// Add a scan result to the hash set
-static inline void IRAM_ATTR add_scan_result(
-    uint8_t *bssid,
-    uint8_t *ssid,
-    uint8_t ssid_len,
-    uint8_t channel,
-    int8_t rssi,
-    bool is_probe_resp)
-{
-    // Check if we exceed maximum scan count.
-    if (HASH_COUNT(scan_results) >= MAX_SCAN_RESULTS)
+// Seed the channel order, the dwell per channel and the connect target from the newest stored sweep
+static void load_scan_history()
+{
+    if (!scan_store_init(&scan_store))
+    {
         return;
+    }
 
-    // Check if the BSSID is already in the hash set
-    scan_result_t *result;
-    HASH_FIND(hh, scan_results, bssid, 6, result);
+    static scan_store_rec_t rec; // keep the record off the main task stack
+    if (!scan_store_load(&scan_store, &rec))
+    {
+        ESP_LOGI(PRINT, "WARM START: no stored sweep history");
+        return;
+    }
+
+    memcpy(chan_scheduler.score, rec.chan_score, sizeof(chan_scheduler.score));
 
-    if (result)
+    // channels that had BSSIDs get a dwell sized for them instead of the first-visit default
+    for (int i = 0; i < rec.num_bssids; i++)
     {
-        // Update the existing entry
-        result->channel = channel;
-        result->rssi = rssi;
-        if (is_probe_resp)
+        uint8_t channel = rec.bssids[i].channel;
+        if (channel >= 1 && channel <= NUM_CHANNELS)
         {
-            result->recvResponse = true;
+            chan_history[channel - 1].visits = 1;
+            if (chan_history[channel - 1].activity < CHAN_ACTIVITY_FULL)
+            {
+                chan_history[channel - 1].activity += 1 << 4;
+            }
         }
     }
-    else
+
+    if (rec.target_channel >= 1 && rec.target_channel <= NUM_CHANNELS)
     {
-        // Create a new entry, we have not seen this BSSID before
-        result = (scan_result_t *)malloc(sizeof(scan_result_t));
-        memcpy(result->bssid, bssid, 6);
-        memcpy(result->ssid, ssid, ssid_len);
-        result->ssid[ssid_len] = '\0'; // Ensure SSID is null-terminated
-        result->channel = channel;
-        result->rssi = rssi;
-        // Add to the hash set
-        HASH_ADD(hh, scan_results, bssid, 6, result);
+        memcpy(warm_bssid, rec.target_bssid, 6);
+        warm_channel = rec.target_channel;
     }
+    memcpy(stored_target_bssid, rec.target_bssid, 6);
+    stored_target_channel = rec.target_channel;
+
+    ESP_LOGI(PRINT, "WARM START: sweep history #%u, %u BSSIDs, target " MACSTR " on chan %d",
+             (unsigned)rec.seq, rec.num_bssids, MAC2STR(rec.target_bssid), rec.target_channel);
 }
 
-// Function to clear the entire hash set
-static inline void IRAM_ATTR clear_scan_results()
+// Write the sweep history to flash. Batched to bound flash wear: only every STORE_EVERY_SWEEPS
+// sweeps, or right away when the connect target changed since it is what a warm start needs most.
+static void save_scan_history()
 {
-    scan_result_t *current_entry, *tmp;
+    uint8_t bssid[6] = {0};
+    uint8_t channel = 0;
+    connect_target(bssid, &channel);
+
+    bool target_moved = channel != stored_target_channel || memcmp(bssid, stored_target_bssid, 6) != 0;
+    sweeps_since_store += 1;
+    if (!target_moved && sweeps_since_store < STORE_EVERY_SWEEPS)
+    {
+        return;
+    }
+
+    static scan_store_rec_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.sweep = scan_sweep;
+    rec.target_channel = channel;
+    memcpy(rec.target_bssid, bssid, 6);
+    memcpy(rec.chan_score, chan_scheduler.score, sizeof(rec.chan_score));
+
+    // keep the SCAN_STORE_BSSIDS entries that would be evicted last
+    const scan_result_t *kept[SCAN_STORE_BSSIDS];
+    int num_kept = 0;
+    scan_result_t *entry;
+    int cursor = 0;
+    while ((entry = bssid_table_next(&scan_results.index, &cursor)) != NULL)
+    {
+        if (num_kept < SCAN_STORE_BSSIDS)
+        {
+            kept[num_kept++] = entry;
+            continue;
+        }
+        int first_out = 0;
+        for (int i = 1; i < num_kept; i++)
+        {
+            if (result_evicts_before(kept[i], kept[first_out]))
+            {
+                first_out = i;
+            }
+        }
+        if (result_evicts_before(kept[first_out], entry))
+        {
+            kept[first_out] = entry;
+        }
+    }
+    for (int i = 0; i < num_kept; i++)
+    {
+        memcpy(rec.bssids[i].bssid, kept[i]->bssid, 6);
+        rec.bssids[i].channel = kept[i]->channel;
+        rec.bssids[i].rssi = rssi_stats_avg(&kept[i]->stats);
+        rec.bssids[i].last_sweep = kept[i]->sweep;
+    }
+    rec.num_bssids = (uint8_t)num_kept;
+
+    if (scan_store_save(&scan_store, &rec))
+    {
+        sweeps_since_store = 0;
+        memcpy(stored_target_bssid, bssid, 6);
+        stored_target_channel = channel;
+        ESP_LOGI(PRINT, "STORED SWEEP HISTORY #%u (%u writes since boot)", (unsigned)rec.seq, (unsigned)scan_store.writes);
+    }
+}
+
+// Stop the channel hopping and sniffing of a probe or sniff sweep
+static void finish_hop_sweep()
+{
+    cancel_probe_delay();
+    stop_timer(chanDwell_timer_handler);
+    chan_deadline_us = NO_DEADLINE;
+    stop_probe_burst();
+    ESP_LOGI(PRINT, "STOP ALL TIMERS");
+
+    frame_ring_stats_t ring_stats;
+    frame_ring_get_stats(&rx_ring, &ring_stats);
+    ESP_LOGI(PRINT, "RX RING: pushed %u, dropped %u, truncated %u, high water %u/%d",
+             (unsigned)ring_stats.pushed, (unsigned)ring_stats.dropped,
+             (unsigned)ring_stats.truncated, (unsigned)ring_stats.high_water, FRAME_RING_SLOTS);
+    SCAN_TRACE_DUMP();
+
+    esp_wifi_set_promiscuous(false);
+    ESP_LOGI(PRINT, "Disabled promiscuous mode");
+    esp_wifi_set_promiscuous_rx_cb(NULL);
+}
+
+static void finished_dynamo_probe()
+{
+
+    // bool flag control for a single scan event
+    if (scan_finish)
+    {
+        return;
+    }
+    scan_finish = true;
+    scan_end_us = esp_timer_get_time();
+    SCAN_TRACE_EVENT(TRACE_SWEEP_END, curr_chan_idx + 1, num_discoveries);
+    ESP_LOGI(PRINT, "FINISHED SCANNING");
+
+    if (sweep_backend != SCAN_BACKEND_DRIVER)
+    {
+        finish_hop_sweep();
+    }
 
-    // // Iterate over the hash set and reset each entry
-    // HASH_ITER(hh, scan_results, current_entry, tmp)
-    // {
-    //     current_entry->updated = false; // Reset the updated flag
-    // }
+    report_scan_results();
+    print_discovery_latency();
+    ESP_LOGI(PRINT, "SWEEP %u DONE [%s]: %u ms, %u new BSSIDs, %u in table, %u probes sent, %u failed",
+             scan_sweep, scan_backend_name(sweep_backend), (unsigned)((scan_end_us - sweep_start_us) / 1000),
+             num_discoveries, result_table_count(&scan_results), sweep_probes, sweep_probe_failures);
+    print_chan_stats();
+    print_latency_stats();
+    ESP_LOGI(PRINT, "RESULT POOL: %u/%d in use, high water %u, %u evicted, %u resets",
+             result_pool_in_use(&scan_results.pool), MAX_SCAN_RESULTS,
+             result_pool_high_water(&scan_results.pool), (unsigned)scan_results.evictions,
+             (unsigned)scan_results.resets);
+
+    if (!home_chan)
+    {
+        connect_sta();
+    }
+    else
+    {
+        if (sweep_backend != SCAN_BACKEND_DRIVER)
+        {
+            return_to_home_channel(); // the driver goes back to the AP by itself
+        }
+#if ROAM_TO_STRONGER_AP
+        roam_to_stronger_ap();
+#endif
+    }
+    save_scan_history();
+
+    // timers and the results table are kept for the next sweep, see start_sweep
+    ESP_ERROR_CHECK(esp_timer_start_once(sweep_timer_handler, (uint64_t)SCAN_INTERVAL * 1000));
+    ESP_LOGI(PRINT, "NEXT SWEEP IN %d ms", SCAN_INTERVAL);
 }
 
-// Debug Function to print the number of items in the hash set
-static inline void IRAM_ATTR print_num_scan_results()
+/************************************************************
+ *                SCAN RESULTS AND HASH                     *
+ *                -Primarily sourced from inject.c          *
+ ************************************************************/
+
+void request_scan_snapshot(void)
 {
-    unsigned int num_items = HASH_COUNT(scan_results); // Use HASH_COUNT to get the number of items
-    printf("Scan results: %u\n", num_items);
+    snapshot_requested = true;
+}
+
+// Report the table at the end of a sweep: a full snapshot every FULL_SNAPSHOT_EVERY sweeps, when
+// requested or after the table was reset, only what changed otherwise
+static void report_scan_results()
+{
+    // drop entries that have not been heard for RESULT_STALE_SWEEPS sweeps
+    result_table_age(&scan_results, scan_sweep, RESULT_STALE_SWEEPS);
+
+    sweeps_since_snapshot += 1;
+    if (snapshot_requested || scan_results.delta.snapshot_due || sweeps_since_snapshot >= FULL_SNAPSHOT_EVERY)
+    {
+        snapshot_requested = false;
+        sweeps_since_snapshot = 0;
+        result_delta_snapshot(&scan_results.delta, &scan_results.index, scan_sweep);
+    }
+    else
+    {
+        result_delta_report(&scan_results.delta, &scan_results.index, scan_sweep);
+    }
 }
 
 /************************************************************
  *                      PROBING BEHAVIOR                    *
  ************************************************************/
 
-bool is_probe_request(void *buff)
+bool is_probe_request(const uint8_t *payload)
 {
-    wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
-    uint8_t *payload = ppkt->payload;
     return (payload[0] & 0xFC) == 0x40;
 }
 
-bool is_probe_response(void *buff)
+bool is_probe_response(const uint8_t *payload)
 {
-    wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
-    uint8_t *payload = ppkt->payload;
     return (payload[0] & 0xFC) == 0x50;
 }
 
-// Callback when packets are received in monitor mode
+bool is_beacon(const uint8_t *payload)
+{
+    return (payload[0] & 0xFC) == FRAME_SUBTYPE_BEACON;
+}
+
+// Callback when packets are received in monitor mode.
+// Runs in the Wi-Fi driver task, so only copy the frame out and wake scan_rx_task.
 void IRAM_ATTR listen_handler(void *buff, wifi_promiscuous_pkt_type_t type)
 {
-    if (scan_finish)
+    // the home channel is covered by its own visit in the plan, not while we are back for the link
+    if (scan_finish || at_home)
     {
         return;
     }
@@ -379,124 +1274,222 @@ void IRAM_ATTR listen_handler(void *buff, wifi_promiscuous_pkt_type_t type)
         return;
     }
 
-    bool is_probe_req = is_probe_request(buff);
-    bool is_probe_resp = is_probe_response(buff);
+    wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
+
+    // drop anything that is not a probe req/resp here so it does not take up a ring slot,
+    // passive sweeps also take beacons
+    if (!is_probe_request(ppkt->payload) && !is_probe_response(ppkt->payload) &&
+        !(sweep_backend == SCAN_BACKEND_SNIFF && is_beacon(ppkt->payload)))
+    {
+        return;
+    }
+
+    if (frame_ring_push(&rx_ring, ppkt->payload, ppkt->rx_ctrl.sig_len,
+                        ppkt->rx_ctrl.rssi, ppkt->rx_ctrl.channel, ppkt->rx_ctrl.timestamp))
+    {
+        xTaskNotifyGive(scan_rx_task_handle);
+    }
+}
+
+// Process every frame currently in rx_ring, then the timer expiries and the results of a finished
+// driver scan. Frames go first, they arrived before we got round to the expiry. Sweeps of every
+// backend start and end here, so this task is the only one that touches the results table.
+static void scan_rx_drain()
+{
+    const frame_slot_t *slot;
+    while ((slot = frame_ring_peek(&rx_ring)) != NULL)
+    {
+        process_frame(slot);
+        frame_ring_release(&rx_ring);
+    }
+
+    unsigned events = atomic_exchange(&scan_events, 0);
+    if (events & SCAN_EVENT_PROBE_DELAY)
+    {
+        probe_delay_expired();
+    }
+    if (events & SCAN_EVENT_BURST)
+    {
+        burst_tick();
+    }
+    if (events & SCAN_EVENT_CHAN_DWELL)
+    {
+        chan_dwell_expired();
+    }
+    if (events & SCAN_EVENT_SWEEP)
+    {
+        start_sweep();
+    }
+
+    if (scan_driver_done())
+    {
+        uint16_t added = scan_driver_collect(&scan_results, scan_sweep);
+        // the driver only hands over results at the end, so that is when they were discovered
+        uint32_t now_ms = (uint32_t)((esp_timer_get_time() - sweep_start_us) / 1000);
+        while (added-- > 0 && num_discoveries < MAX_DISCOVERIES)
+        {
+            discovery_ms[num_discoveries++] = now_ms;
+        }
+        finished_dynamo_probe();
+    }
+}
+
+// Owns the sweep: drains rx_ring and runs the timer expiries, everything that used to run inside
+// listen_handler and the esp_timer callbacks happens here
+static void scan_rx_task(void *arg)
+{
+    (void)arg;
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        scan_rx_drain();
+    }
+}
 
-    if (!is_probe_req && !is_probe_resp)
-    { // drop packet if its not a probe resp or req
-        // keep probe delay timer running
+static void process_frame(const frame_slot_t *slot)
+{
+    if (scan_finish || at_home)
+    {
         return;
     }
 
+    const uint8_t *payload = slot->data;
+    bool is_probe_req = is_probe_request(payload);
+    bool is_probe_resp = is_probe_response(payload);
+    bool is_beacon_frame = is_beacon(payload);
+
     if (is_probe_req)
     {
-        ESP_LOGI(PRINT, "####### PROBE REQUEST SNIIFED #######");
+        SCAN_TRACE_FRAME(TRACE_PROBE_REQ_RX, slot->channel, (uint16_t)slot->rssi);
     }
     else if (is_probe_resp)
     {
-        ESP_LOGI(PRINT, "####### PROBE RESPONSE SNIFFED #######");
+        SCAN_TRACE_FRAME(TRACE_PROBE_RESP_RX, slot->channel, (uint16_t)slot->rssi);
+    }
+    else if (is_beacon_frame)
+    {
+        SCAN_TRACE_FRAME(TRACE_BEACON_RX, slot->channel, (uint16_t)slot->rssi);
     }
 
     // If probe delay active, Stop probe_delay timer upon sniffing a relevant packet, continue to sniff on this chan for chanDwell
 
-    if (esp_timer_is_active(probe_timer_handler))
+    // the probe delay may have expired already, then its queued expiry starts the burst and the dwell
+    if (stop_timer(probe_timer_handler))
     {
-        ESP_LOGI(PRINT, "****** STOP PROBE TIMER IN LISTEN HANDLER ****");
-        ESP_ERROR_CHECK(esp_timer_stop(probe_timer_handler));
+        probe_deadline_us = NO_DEADLINE;
+        SCAN_TRACE_FRAME(TRACE_PROBE_TIMER_STOPPED, slot->channel, 0);
 
         // Start chanDwell timer on this channel, if it has not already been started by a previous listen event
         // if it has been started by probe_delay expiring, we do not start
-        if (!esp_timer_is_active(chanDwell_timer_handler))
+        if (chan_deadline_us == NO_DEADLINE)
         {
-            ESP_LOGI(PRINT, "****** STARTED CHAN DWELL TIMER IN LISTEN HANDLER ****");
-            ESP_ERROR_CHECK(esp_timer_start_once(chanDwell_timer_handler, CHAN_DWELL_TIME * 1000)); // 1,000,000 microseconds = 1 second, this value is CHAN_DWELL_TIME ms
+            SCAN_TRACE_FRAME(TRACE_DWELL_AFTER_RX, slot->channel, 0);
+            start_chan_dwell(CHAN_DWELL_TIME); // without history, dwell CHAN_DWELL_TIME ms
         }
     }
     else
     {
-        ESP_LOGI(PRINT, "****** PROBE DELAY IS NOT ACTIVE ****");
+        SCAN_TRACE_FRAME(TRACE_PROBE_DELAY_INACTIVE, slot->channel, 0);
     }
 
-    // // Start chanDwell timer on this channel, if it has not already been started by a previous listen event
-    // // if it has been started by probe_delay expiring, we do not start
-    // if (!esp_timer_is_active(chanDwell_timer_handler))
-    // {
-    //     ESP_LOGI(PRINT, "****** STARTED CHAN DWELL TIMER IN LISTEN HANDLER ****");
-    //     ESP_ERROR_CHECK(esp_timer_start_once(chanDwell_timer_handler, CHAN_DWELL_TIME * 1000)); // 1,000,000 microseconds = 1 second, this value is CHAN_DWELL_TIME ms
-    // }
-
-    wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
-    uint8_t *payload = ppkt->payload;
-    int packet_len = ppkt->rx_ctrl.sig_len;
-    if (packet_len < 38)
+    // a probe request only told us the channel is busy, it comes from a client, not an AP
+    if (is_probe_req)
     {
-        return; // bad packet, causes memory to crash
+        return;
     }
 
-    // 24 bytes of MAC header, start parsing ie
-    uint8_t *ies = payload + 24;
-    int ies_len = packet_len - 24;
+    // the FCS is only in the slot when the frame was not truncated
+    size_t frame_len = slot->len;
+    if (slot->len == slot->frame_len && frame_len >= FRAME_FCS_LEN)
+    {
+        frame_len -= FRAME_FCS_LEN;
+    }
 
-    int pos = 0;
-    char ssid_str[33] = {0}; // null terminate after 32 bytes
-    while (pos < ies_len)
+    size_t ies_len;
+    const uint8_t *ies = mgmt_frame_ies(payload, frame_len, &ies_len);
+    if (!ies)
     {
-        uint8_t id = ies[pos];
-        uint8_t length = ies[pos + 1];
+        return; // too short to carry any elements
+    }
+
+    mgmt_ies_t parsed;
+    ie_parse(ies, ies_len, &parsed);
 
-        if (id == 0x00) // SSID Element ID
+    // a probe response addressed to us answers our burst (Address 1 is the receiver)
+    if (is_probe_resp && memcmp(payload + 4, probe_builder.mac, 6) == 0)
+    {
+        chan_history[curr_chan_idx].responses += 1;
+        // rx_ctrl.timestamp runs on the MAC clock, so time the round trip on esp_timer when we
+        // get to the frame, this includes the (short) wait in the RX ring
+        if (!burst_answered && burst_start_us >= 0)
         {
-            if (length == 0)
-            {
-                strcpy(ssid_str, "WILDCARD");
-            }
-            else
-            {
-                int copy_len = (length > 32) ? 32 : length;
-                memcpy(ssid_str, ies + pos + 2, copy_len);
-                ssid_str[copy_len] = '\0'; // null termination
-                break;
-            }
+            latency_hist_record(&chan_history[curr_chan_idx].probe_rtt,
+                                (uint32_t)(esp_timer_get_time() - burst_start_us));
         }
-        pos += 2 + length;
+        burst_answered = true;
+        SCAN_TRACE_EVENT(TRACE_PROBE_ANSWERED, slot->channel, (uint16_t)slot->rssi);
     }
 
-    uint8_t *bssid = ppkt->payload + 10; // BSSID is located at offset 10
+    // Address 3 is the BSSID, Address 2 (the transmitter) differs from it on multi-BSSID APs
+    const uint8_t *bssid = payload + 16;
 
-    int8_t ssid_len = ppkt->payload[37]; // SSID length is 1 byte after the Element ID
-    uint8_t *ssid = ppkt->payload + 38;  // SSID starts after length byte
+    // hidden networks beacon a zero length SSID
+    const uint8_t *ssid = parsed.ssid.data ? parsed.ssid.data : (const uint8_t *)"";
+    uint8_t ssid_len = (parsed.ssid.len > IE_SSID_MAX_LEN) ? IE_SSID_MAX_LEN : parsed.ssid.len;
 
-    int8_t rssi = ppkt->rx_ctrl.rssi;
-    uint8_t channel = ppkt->rx_ctrl.channel;
+    int8_t rssi = slot->rssi;
+    // prefer the DS Parameter Set, adjacent channel leakage means we can hear an AP off its own channel
+    uint8_t channel = parsed.ds_channel ? parsed.ds_channel : slot->channel;
 
-    if (num_scan_results < MAX_SCAN_RESULTS)
+    // a TIM makes it an AP beacon (IBSS beacons carry none), its interval sizes the passive dwell
+    // on the channel the AP says it is on
+    if (is_beacon_frame && parsed.dtim_period && channel >= 1 && channel <= NUM_CHANNELS)
     {
-        ESP_LOGI(PRINT, "########### ADDED A SCAN RESULT ################");
-        add_scan_result(bssid, ssid, ssid_len, channel, rssi, is_probe_resp);
-        num_scan_results += 1;
+        chan_history_t *hist = &chan_history[channel - 1];
+        uint16_t beacon_int = mgmt_beacon_interval(payload, frame_len);
+        hist->beacons += 1;
+        if (beacon_int > hist->beacon_int)
+        {
+            hist->beacon_int = beacon_int;
+        }
     }
-    // else
-    // {
-    //     // print_scan_results();
-    //     // clear_scan_results();
-    //     // num_scan_results = 0;
-    //     return;
-    // }
 
-    // scan_result_t *result;
-    // HASH_FIND(hh, scan_results, bssid, 6, result);
-    // bool found = false;
-    // if (result)
-    // {
-    //     found = result->recvResponse;
-    // }
+    uint8_t flags = 0;
+    if (parsed.rsn.data)
+    {
+        flags |= SCAN_RESULT_FLAG_RSN;
+    }
+    if (parsed.ht_caps.data)
+    {
+        flags |= SCAN_RESULT_FLAG_HT;
+    }
+
+    // only beacons and probe responses are left, both come from the AP itself
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (result_table_add(&scan_results, bssid, ssid, ssid_len, channel, rssi, flags, scan_sweep, true, now_ms))
+    {
+        SCAN_TRACE_FRAME(TRACE_RESULT_ADDED, slot->channel, result_table_count(&scan_results));
+        note_chan_discovery();
+    }
 
-    // printf("BSSID: %02x:%02x:%02x:%02x:%02x:%02x, Channel: %d, RSSI: %d, SSID: %s, RESP RECV : %d \n",
-    //        bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5],
-    //        channel,
-    //        rssi,
-    //        ssid_str,
-    //        found);
+#if TARGETED_SCAN
+    // only an AP answers with a probe response, a probe request for our SSID may just be another client.
+    // The race is only on for the probe sweep before the first connect: later sweeps cover every
+    // channel, and a passive sweep keeps its fixed length whoever else is probing.
+    bool racing = sweep_backend == SCAN_BACKEND_PROBE && !home_chan && !sta_started;
+    if (racing && is_probe_resp && !target_seen && ssid_len == strlen(WIFI_SSID) && memcmp(ssid, WIFI_SSID, ssid_len) == 0)
+    {
+        ESP_LOGI(PRINT, "TARGET SSID %s SEEN ON CHAN %d, ENDING SWEEP", WIFI_SSID, channel);
+        SCAN_TRACE_EVENT(TRACE_TARGET_SEEN, slot->channel, channel);
+        target_seen = true;
+        memcpy(target_bssid, bssid, sizeof(target_bssid));
+        target_channel = channel;
+
+        // expire the dwell now, the sweep ends through the queued expiry like it normally does
+        chan_deadline_us = esp_timer_get_time();
+        arm_chan_dwell(chan_deadline_us);
+    }
+#endif
 }
 
 /************************************************************
@@ -532,12 +1525,7 @@ void wifi_init()
         .filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT};
     ESP_ERROR_CHECK(esp_wifi_set_promiscuous_filter(&filter));
 
-    // Setup promiscuous mode
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
-
-    // Set the promiscuous mode receive callback.
-    // ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(wifi_sniffer_packet_handler));
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(listen_handler));
+    // Promiscuous mode and the receive callback are switched on by start_sweep()
 
     // Set transmit PHY rate to lowest in 802.11n
     // (see https://github.com/espressif/esp-idf/blob/master/components/esp_wifi/include/esp_wifi_types_generic.h#L874)
@@ -546,49 +1534,58 @@ void wifi_init()
     // Set protocol.
     ESP_ERROR_CHECK(esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_11B));
 
-    // wifi_config_t wifi_config = {
-    //     .sta = {
-    //         .ssid = WIFI_SSID,
-    //         .password = WIFI_PASS,
-    //         .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-    //     },
-    // };
-
     // Start Wi-Fi stack.
     ESP_ERROR_CHECK(esp_wifi_start());
 
     // Set max TX power.
     ESP_ERROR_CHECK(esp_wifi_set_max_tx_power(84));
 
-    // Set channel.
-    // ESP_ERROR_CHECK(esp_wifi_set_channel(11, WIFI_SECOND_CHAN_NONE));
-    ESP_ERROR_CHECK(esp_wifi_set_channel(wifi_channels[curr_chan_idx], WIFI_SECOND_CHAN_NONE));
-
     // Set bandwidth, 2.4 ghz
     ESP_ERROR_CHECK(esp_wifi_set_bandwidth(WIFI_IF_STA, WIFI_BW_HT20));
-
-    // ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
 }
 
 void app_main(void)
 {
-    ESP_ERROR_CHECK(nvs_flash_init());
+    // NVS also holds the sweep history, start over if the partition cannot be used as it is
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta(); // DHCP client, needed for IP_EVENT_STA_GOT_IP
+
+    // consumer for sniffed frames has to exist before the promiscuous callback is registered
+    frame_ring_init(&rx_ring);
+    chan_sched_init(&chan_scheduler);
+    load_scan_history();
+    result_table_init(&scan_results);
+    xTaskCreate(scan_rx_task, "scan_rx", SCAN_RX_TASK_STACK, NULL, SCAN_RX_TASK_PRIO, &scan_rx_task_handle);
+    scan_driver_init(scan_rx_task_handle);
 
     wifi_init();
     init_timers();
 
-    // start probe delay timer, triggers active scan upon expiration if not interrupted by listen
-    ESP_ERROR_CHECK(esp_timer_start_once(probe_timer_handler, PROBE_DELAY * 1000)); // 1,000,000 microseconds = 1 second, this value is PROBE_DELAY ms
+    uint8_t sta_mac[6];
+    ESP_ERROR_CHECK(esp_wifi_get_mac(WIFI_IF_STA, sta_mac));
+    probe_builder_init(&probe_builder, sta_mac, WIFI_SSID);
+
+    if (warm_channel)
+    {
+        // we know where the AP was before the reset, join it straight away and scan once connected
+        scan_end_us = esp_timer_get_time();
+        connect_sta();
+        ESP_ERROR_CHECK(esp_timer_start_once(sweep_timer_handler, (uint64_t)WARM_SWEEP_DELAY * 1000));
+    }
+    else
+    {
+        // first sweep, the following ones are started by the sweep timer every SCAN_INTERVAL
+        post_scan_event(SCAN_EVENT_SWEEP);
+    }
 
     ESP_LOGI(PRINT, "~~~~~~~~~~~~~~~~~~~~~~ START  ~~~~~~~~~~~~~~~~~~~~~~");
     ESP_LOGI(PRINT, "FIRST PROBE DELAY STARTS HERE");
-
-    // uint8_t mac[6];
-    // esp_read_mac(mac, ESP_MAC_WIFI_STA); // Read the MAC address for Wi-Fi station
-
-    // printf("MAC Address: %02X:%02X:%02X:%02X:%02X:%02X\n",
-    //        mac[0], mac[1], mac[2],
-    //        mac[3], mac[4], mac[5]);
 }
\ No newline at end of file
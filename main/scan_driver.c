@@ -0,0 +1,260 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+#include "latency_hist.h"
+#include "scan_driver.h"
+
+#define JITTER_PROBE_PERIOD 10   // ms, period of the timer that measures how late the esp_timer task runs
+#define AP_PAGE_SIZE 8           // AP records fetched from the driver per page
+
+static const char *TAG = "[ DRIVER ]";
+static esp_timer_handle_t jitter_timer = NULL;
+#if BLOCKING_SCAN
+static esp_timer_handle_t blocking_scan_timer = NULL;
+#endif
+static TaskHandle_t scan_worker = NULL;
+
+// How late the jitter probe timer fires. Every other esp_timer callback shares the esp_timer task,
+// so anything that blocks in a callback shows up here.
+static latency_hist_t timer_jitter;
+static int64_t jitter_expected_us = 0;
+static latency_hist_t scan_start_time; // time spent in esp_wifi_scan_start, i.e. blocking the caller
+static int64_t scan_started_us = 0;
+static volatile bool scan_running = false;
+static volatile bool scan_done = false;
+
+static wifi_ap_record_t ap_page[AP_PAGE_SIZE]; // reused for every page of every scan
+
+// Timing units are in milliseconds
+static wifi_scan_config_t scan_config = {
+    .ssid = NULL,
+    .bssid = NULL,
+    .channel = 0, // every channel the country allows
+    .show_hidden = true,
+    .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+    .scan_time = {
+        .active = {
+            .min = 0,
+            .max = 120 // ms per channel
+        }
+    },
+    .home_chan_dwell_time = 250 // ms
+};
+
+/*** TIMER JITTER ***/
+
+static void jitter_probe_cb(void *arg)
+{
+    (void)arg;
+    int64_t now = esp_timer_get_time();
+    if (jitter_expected_us)
+    {
+        int64_t late = now - jitter_expected_us;
+        latency_hist_record(&timer_jitter, late > 0 ? (uint32_t)late : 0);
+    }
+    jitter_expected_us = now + JITTER_PROBE_PERIOD * 1000;
+}
+
+// Only runs during a driver sweep, from scan_driver_start to scan_driver_collect
+static void start_jitter_probe()
+{
+    jitter_expected_us = 0;
+    ESP_ERROR_CHECK(esp_timer_start_periodic(jitter_timer, JITTER_PROBE_PERIOD * 1000));
+}
+
+// Stop the probe and log what it saw during this sweep, the next sweep starts from an empty histogram
+static void stop_jitter_probe()
+{
+    esp_timer_stop(jitter_timer);
+    ESP_LOGI(TAG, "TIMER JITTER (%s): p50 %u us p99 %u us max %u us over %u ticks, scan start p50 %u us max %u us",
+             BLOCKING_SCAN ? "blocking scan from the timer task" : "async scan",
+             (unsigned)latency_hist_percentile(&timer_jitter, 50),
+             (unsigned)latency_hist_percentile(&timer_jitter, 99),
+             (unsigned)timer_jitter.max_us,
+             (unsigned)latency_hist_count(&timer_jitter),
+             (unsigned)latency_hist_percentile(&scan_start_time, 50),
+             (unsigned)scan_start_time.max_us);
+    latency_hist_init(&timer_jitter);
+}
+
+/*** SCAN ***/
+
+// Runs on the default event loop task, hand over to the worker rather than reading records here
+static void scan_done_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    (void)arg;
+    (void)event_base;
+    (void)event_id;
+    if (!scan_running)
+    {
+        return; // someone else's scan, e.g. the driver's own before a connect
+    }
+
+    wifi_event_sta_scan_done_t *event = (wifi_event_sta_scan_done_t *)event_data;
+    if (event->status != 0)
+    {
+        ESP_LOGW(TAG, "Scan did not complete (status %u)", (unsigned)event->status);
+    }
+    scan_running = false;
+    scan_done = true;
+    xTaskNotifyGive(scan_worker);
+}
+
+// Start the driver scan and time how long the call holds up its caller
+static esp_err_t start_driver_scan(bool block)
+{
+    scan_started_us = esp_timer_get_time();
+    esp_err_t ret = esp_wifi_scan_start(&scan_config, block);
+    latency_hist_record(&scan_start_time, (uint32_t)(esp_timer_get_time() - scan_started_us));
+    return ret;
+}
+
+#if BLOCKING_SCAN
+// What interval-scan.c used to do: a blocking scan from an esp_timer callback, so every other timer
+// waits for it. A scan that fails to start still ends the sweep, through an empty collect.
+static void blocking_scan_cb(void *arg)
+{
+    (void)arg;
+    esp_err_t ret = start_driver_scan(true);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Scan failed: %s", esp_err_to_name(ret));
+        scan_running = false;
+        scan_done = true;
+        xTaskNotifyGive(scan_worker);
+    }
+}
+#endif
+
+void scan_driver_init(TaskHandle_t worker)
+{
+    scan_worker = worker;
+    latency_hist_init(&timer_jitter);
+    latency_hist_init(&scan_start_time);
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &scan_done_handler, NULL));
+
+    const esp_timer_create_args_t jitter_args = {
+        .callback = &jitter_probe_cb,
+        .name = "jitter_probe"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&jitter_args, &jitter_timer));
+#if BLOCKING_SCAN
+    const esp_timer_create_args_t blocking_args = {
+        .callback = &blocking_scan_cb,
+        .name = "blocking_scan"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&blocking_args, &blocking_scan_timer));
+#endif
+}
+
+bool scan_driver_start(void)
+{
+    if (scan_running)
+    {
+        ESP_LOGW(TAG, "Previous scan still running, skipping this one");
+        return false;
+    }
+
+    scan_running = true;
+    scan_done = false;
+    start_jitter_probe();
+#if BLOCKING_SCAN
+    ESP_ERROR_CHECK(esp_timer_start_once(blocking_scan_timer, 0));
+#else
+    esp_err_t ret = start_driver_scan(false);
+    if (ret != ESP_OK)
+    {
+        scan_running = false;
+        stop_jitter_probe();
+        ESP_LOGE(TAG, "Scan failed: %s", esp_err_to_name(ret));
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool scan_driver_done(void)
+{
+    return scan_done;
+}
+
+// Whether the AP advertises an RSN element, like ie_parse reports it for the probe and sniff
+// backends. Listed one by one, the enum is not ordered by strength: WAPI and WPA1 Enterprise come
+// after RSN modes and carry no RSN element.
+static bool auth_uses_rsn(wifi_auth_mode_t authmode)
+{
+    switch (authmode)
+    {
+    case WIFI_AUTH_WPA2_PSK:
+    case WIFI_AUTH_WPA_WPA2_PSK:
+    case WIFI_AUTH_WPA2_ENTERPRISE:
+    case WIFI_AUTH_WPA3_PSK:
+    case WIFI_AUTH_WPA2_WPA3_PSK:
+    case WIFI_AUTH_OWE:
+    case WIFI_AUTH_WPA3_ENT_192:
+    case WIFI_AUTH_WPA3_EXT_PSK:
+    case WIFI_AUTH_WPA3_EXT_PSK_MIXED_MODE:
+    case WIFI_AUTH_DPP:
+    case WIFI_AUTH_WPA3_ENTERPRISE:
+    case WIFI_AUTH_WPA2_WPA3_ENTERPRISE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint16_t scan_driver_collect(result_table_t *table, uint16_t sweep)
+{
+    scan_done = false;
+    stop_jitter_probe();
+    ESP_LOGI(TAG, "Scan took %u ms", (unsigned)((esp_timer_get_time() - scan_started_us) / 1000));
+
+    uint16_t ap_count = 0;
+    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_count));
+
+    // The driver holds the whole list, take it a page at a time so no AP is dropped however many
+    // there are. Each esp_wifi_scan_get_ap_record hands over one record and frees it in the driver.
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint16_t fetched = 0;
+    uint16_t added = 0;
+    bool more = true;
+    while (more)
+    {
+        int n = 0;
+        while (n < AP_PAGE_SIZE && esp_wifi_scan_get_ap_record(&ap_page[n]) == ESP_OK)
+        {
+            n++;
+        }
+        more = n == AP_PAGE_SIZE;
+
+        for (int i = 0; i < n; i++)
+        {
+            const wifi_ap_record_t *ap = &ap_page[i];
+            uint8_t flags = 0;
+            if (auth_uses_rsn(ap->authmode))
+            {
+                flags |= SCAN_RESULT_FLAG_RSN;
+            }
+            if (ap->phy_11n)
+            {
+                flags |= SCAN_RESULT_FLAG_HT;
+            }
+            // the driver only keeps APs that answered or beaconed, count them as responses
+            if (result_table_add(table, ap->bssid, ap->ssid, (uint8_t)strnlen((const char *)ap->ssid, 32),
+                                 ap->primary, ap->rssi, flags, sweep, true, now_ms))
+            {
+                added += 1;
+            }
+        }
+        fetched += n;
+    }
+    ESP_LOGI(TAG, "Scan completed. Found %u APs, fetched %u, %u new, %u in table",
+             ap_count, fetched, added, result_table_count(table));
+
+    // drops anything the loop above left behind, e.g. after a failed fetch
+    esp_wifi_clear_ap_list();
+    return added;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "scan_store.h"
+
+static const char *STORE = "[ STORE ]";
+
+static void slot_key(uint8_t slot, char *key, size_t len)
+{
+    snprintf(key, len, "sweep%u", slot);
+}
+
+// Read slot into rec, false if it is missing, the wrong size or another version
+static bool read_slot(scan_store_t *store, uint8_t slot, scan_store_rec_t *rec)
+{
+    char key[16];
+    size_t len = sizeof(*rec);
+    slot_key(slot, key, sizeof(key));
+
+    if (nvs_get_blob(store->handle, key, rec, &len) != ESP_OK || len != sizeof(*rec))
+    {
+        return false;
+    }
+    return rec->version == SCAN_STORE_VERSION && rec->num_bssids <= SCAN_STORE_BSSIDS;
+}
+
+bool scan_store_init(scan_store_t *store)
+{
+    memset(store, 0, sizeof(*store));
+
+    esp_err_t err = nvs_open(SCAN_STORE_NAMESPACE, NVS_READWRITE, &store->handle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(STORE, "nvs_open failed (%s), sweep history will not be kept", esp_err_to_name(err));
+        return false;
+    }
+    store->open = true;
+
+    scan_store_rec_t rec;
+    bool found = false;
+    for (uint8_t slot = 0; slot < SCAN_STORE_SLOTS; slot++)
+    {
+        if (read_slot(store, slot, &rec) && (!found || rec.seq > store->seq))
+        {
+            found = true;
+            store->seq = rec.seq;
+            store->next_slot = (slot + 1) % SCAN_STORE_SLOTS;
+        }
+    }
+    return true;
+}
+
+bool scan_store_load(scan_store_t *store, scan_store_rec_t *rec)
+{
+    if (!store->open)
+    {
+        return false;
+    }
+
+    // newest first, fall back to older slots should the newest one not read back
+    for (uint8_t i = 1; i <= SCAN_STORE_SLOTS; i++)
+    {
+        uint8_t slot = (store->next_slot + SCAN_STORE_SLOTS - i) % SCAN_STORE_SLOTS;
+        if (read_slot(store, slot, rec))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool scan_store_save(scan_store_t *store, scan_store_rec_t *rec)
+{
+    if (!store->open)
+    {
+        return false;
+    }
+
+    char key[16];
+    slot_key(store->next_slot, key, sizeof(key));
+    rec->version = SCAN_STORE_VERSION;
+    rec->seq = store->seq + 1;
+
+    esp_err_t err = nvs_set_blob(store->handle, key, rec, sizeof(*rec));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(store->handle);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(STORE, "writing %s failed (%s)", key, esp_err_to_name(err));
+        return false;
+    }
+
+    store->seq = rec->seq;
+    store->next_slot = (store->next_slot + 1) % SCAN_STORE_SLOTS;
+    store->writes += 1;
+    return true;
+}
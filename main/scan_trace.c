@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "scan_trace.h"
+
+static const char *const event_names[TRACE_EVENT_COUNT] = {
+    [TRACE_PROBE_DELAY_EXPIRED] = "PROBE_DELAY_EXPIRED",
+    [TRACE_PROBE_SENT] = "PROBE_SENT",
+    [TRACE_DWELL_AFTER_PROBE] = "DWELL_AFTER_PROBE",
+    [TRACE_DWELL_EXPIRED] = "DWELL_EXPIRED",
+    [TRACE_CHAN_SWITCH] = "CHAN_SWITCH",
+    [TRACE_SWEEP_START] = "SWEEP_START",
+    [TRACE_CHAN_LEAVE] = "CHAN_LEAVE",
+    [TRACE_PROBE_ANSWERED] = "PROBE_ANSWERED",
+    [TRACE_DWELL_EXTENDED] = "DWELL_EXTENDED",
+    [TRACE_TARGET_SEEN] = "TARGET_SEEN",
+    [TRACE_SWEEP_END] = "SWEEP_END",
+    [TRACE_HOME_DWELL] = "HOME_DWELL",
+    [TRACE_PROBE_REQ_RX] = "PROBE_REQ_RX",
+    [TRACE_PROBE_RESP_RX] = "PROBE_RESP_RX",
+    [TRACE_PROBE_TIMER_STOPPED] = "PROBE_TIMER_STOPPED",
+    [TRACE_DWELL_AFTER_RX] = "DWELL_AFTER_RX",
+    [TRACE_PROBE_DELAY_INACTIVE] = "PROBE_DELAY_INACTIVE",
+    [TRACE_RESULT_ADDED] = "RESULT_ADDED",
+    [TRACE_BEACON_RX] = "BEACON_RX",
+};
+
+const char *scan_trace_event_name(uint8_t event)
+{
+    return event < TRACE_EVENT_COUNT ? event_names[event] : NULL;
+}
+
+#if SCAN_TRACE_LEVEL > SCAN_TRACE_NONE
+
+#define SCAN_TRACE_MASK (SCAN_TRACE_DEPTH - 1)
+
+_Static_assert((SCAN_TRACE_DEPTH & SCAN_TRACE_MASK) == 0, "SCAN_TRACE_DEPTH must be a power of two");
+
+static const char *TRACE = "[ TRACE ]";
+
+static scan_trace_rec_t trace_ring[SCAN_TRACE_DEPTH];
+// Only scan_rx_task emits and dumps, so the ring has a single writer and needs no atomics
+static unsigned trace_head; // total records ever emitted
+static unsigned trace_tail; // records up to here have been dumped
+
+void scan_trace_emit(uint8_t event, uint8_t channel, uint16_t arg)
+{
+    scan_trace_rec_t *rec = &trace_ring[trace_head++ & SCAN_TRACE_MASK];
+
+    rec->time_us = (uint32_t)esp_timer_get_time();
+    rec->event = event;
+    rec->channel = channel;
+    rec->arg = arg;
+}
+
+// One "T <seq> <time_us> <channel> <event> <arg>" line per record, the format host/trace_decode.c reads.
+// Only records emitted since the previous dump are printed.
+void scan_trace_dump(void)
+{
+    unsigned head = trace_head;
+    unsigned first = head - trace_tail > SCAN_TRACE_DEPTH ? head - SCAN_TRACE_DEPTH : trace_tail;
+
+    ESP_LOGI(TRACE, "%u records, %u overwritten", head - first, first - trace_tail);
+    trace_tail = head;
+    for (unsigned i = first; i < head; i++)
+    {
+        const scan_trace_rec_t *rec = &trace_ring[i & SCAN_TRACE_MASK];
+        const char *name = scan_trace_event_name(rec->event);
+        printf("T %5u %10u %2u %-20s %u\n", i, (unsigned)rec->time_us, rec->channel, name ? name : "?", rec->arg);
+    }
+}
+
+#endif